@@ -5,6 +5,7 @@
 // C STANDARD
 #include <stdbool.h>        // bool
 #include <stdint.h>         // uint16_t, uint32_t
+#include <string.h>         // memset
 
 // NRF
 #include "boards.h"         // bsp_board_leds_on
@@ -23,11 +24,17 @@
 #include "app_error.h"      // APP_ERROR_CHECK
 
 // SOFTDEVICE
-#include "ble.h"            // ble_evt_t
+#include "ble.h"            // ble_evt_t, ble_cfg_t, sd_ble_cfg_set
+#include "ble_gatt.h"       // BLE_GATT_ATT_MTU_DEFAULT
 #include "ble_gap.h"        // sd_ble_gap_disconnect
 #include "ble_gatts.h"      // sd_ble_gatts_sys_attr_set
 #include "ble_hci.h"        // BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION
 
+// CUSTOM
+#include "luos_hal_config.h"    /* COM_HVN_TX_QUEUE_SIZE,
+                                ** COM_WRITE_CMD_TX_QUEUE_SIZE
+                                */
+
 /*      STATIC VARIABLES & CONSTANTS                                */
 
 // BLE Observers priority.
@@ -38,6 +45,11 @@ static bool s_connected = false;
 
 static nrf_sdh_ble_evt_handler_t s_ble_gap_obs_cb = NULL;
 
+// ATT MTU of the current connection.
+static uint16_t s_att_mtu = BLE_GATT_ATT_MTU_DEFAULT;
+
+static att_payload_cb_t s_att_payload_cb = NULL;
+
 /*      INITIALIZATIONS                                             */
 
 // GATT module instance.
@@ -45,6 +57,9 @@ NRF_BLE_GATT_DEF(s_gatt_mod);
 
 /*      STATIC FUNCTIONS                                            */
 
+// Sets the SoftDevice connection configuration used by the COM.
+static void conn_cfg_set(uint32_t ram_start_addr);
+
 // Initializes the given GATT module instance.
 static void gatt_instance_init(nrf_ble_gatt_t* instance);
 
@@ -60,6 +75,10 @@ static void ble_gap_obs_event_handler(const ble_evt_t* event,
 static void ble_gatt_obs_event_handler(const ble_evt_t* event,
                                        void* context);
 
+// GATT module event handler: keeps track of the ATT MTU.
+static void gatt_module_event_handler(nrf_ble_gatt_t* instance,
+                                      const nrf_ble_gatt_evt_t* event);
+
 void ble_stack_enable(void)
 {
     ret_code_t err_code;
@@ -69,6 +88,8 @@ void ble_stack_enable(void)
                                            &ram_start_addr);
     APP_ERROR_CHECK(err_code);
 
+    conn_cfg_set(ram_start_addr);
+
     err_code = nrf_sdh_ble_enable(&ram_start_addr);
     APP_ERROR_CHECK(err_code);
 }
@@ -97,15 +118,49 @@ void ble_observers_register(nrf_sdh_ble_evt_handler_t ble_gap_obs_cb)
                          ble_gatt_obs_event_handler, NULL);
 }
 
+uint16_t ble_att_payload_get(void)
+{
+    return s_att_mtu - ATT_HEADER_SIZE;
+}
+
+void ble_att_payload_cb_register(att_payload_cb_t att_payload_cb)
+{
+    s_att_payload_cb = att_payload_cb;
+}
+
 void connection_end_signal(void)
 {
     bsp_board_leds_on();
     while(true);
 }
 
+static void conn_cfg_set(uint32_t ram_start_addr)
+{
+    ble_cfg_t ble_cfg;
+    memset(&ble_cfg, 0, sizeof(ble_cfg_t));
+
+    ble_cfg.conn_cfg.conn_cfg_tag                       = CONN_CFG_TAG;
+    ble_cfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size
+                                                        = COM_HVN_TX_QUEUE_SIZE;
+
+    ret_code_t err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &ble_cfg,
+                                         ram_start_addr);
+    APP_ERROR_CHECK(err_code);
+
+    memset(&ble_cfg, 0, sizeof(ble_cfg_t));
+
+    ble_cfg.conn_cfg.conn_cfg_tag                       = CONN_CFG_TAG;
+    ble_cfg.conn_cfg.params.gattc_conn_cfg.write_cmd_tx_queue_size
+                                                        = COM_WRITE_CMD_TX_QUEUE_SIZE;
+
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTC, &ble_cfg, ram_start_addr);
+    APP_ERROR_CHECK(err_code);
+}
+
 static void gatt_instance_init(nrf_ble_gatt_t* instance)
 {
-    ret_code_t err_code = nrf_ble_gatt_init(instance, NULL);
+    ret_code_t err_code = nrf_ble_gatt_init(instance,
+                                            gatt_module_event_handler);
     APP_ERROR_CHECK(err_code);
 }
 
@@ -150,3 +205,34 @@ static void ble_gatt_obs_event_handler(const ble_evt_t* event,
         break;
     }
 }
+
+static void gatt_module_event_handler(nrf_ble_gatt_t* instance,
+                                      const nrf_ble_gatt_evt_t* event)
+{
+    switch (event->evt_id)
+    {
+    case NRF_BLE_GATT_EVT_ATT_MTU_UPDATED:
+        #ifdef DEBUG
+        NRF_LOG_INFO("ATT MTU updated to %u bytes!",
+                     event->params.att_mtu_effective);
+        #endif /* DEBUG */
+
+        s_att_mtu = event->params.att_mtu_effective;
+        if (s_att_payload_cb != NULL)
+        {
+            s_att_payload_cb(ble_att_payload_get());
+        }
+        break;
+    case NRF_BLE_GATT_EVT_DATA_LENGTH_UPDATED:
+        /* Longer ATT packets are split by the link layer: only the ATT
+        ** MTU bounds the payload.
+        */
+        #ifdef DEBUG
+        NRF_LOG_INFO("Data length updated to %u bytes!",
+                     event->params.data_length);
+        #endif /* DEBUG */
+        break;
+    default:
+        break;
+    }
+}
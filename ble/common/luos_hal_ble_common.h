@@ -9,6 +9,7 @@
 // NRF
 #include "nrf_ble_gatt.h"   // nrf_ble_gatt_t
 #include "nrf_sdh_ble.h"    // nrf_sdh_ble_evt_handler_t
+#include "sdk_config.h"     // NRF_SDH_BLE_GATT_MAX_MTU_SIZE
 #include "sdk_errors.h"     // ret_code_t
 
 /*      CONSTANTS                                                   */
@@ -19,9 +20,18 @@
 // Connection configuration tag.
 #define CONN_CFG_TAG        1
 
+// ATT header size in notifications and write commands: opcode + handle.
+#define ATT_HEADER_SIZE     3
+
+// Largest payload of a notification or write command.
+#define ATT_PAYLOAD_MAX     (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - ATT_HEADER_SIZE)
+
 // Function updating the ATT MTU size.
 typedef ret_code_t(*att_mtu_update_t)(nrf_ble_gatt_t*, uint16_t);
 
+// Function called with the new ATT payload when the ATT MTU changes.
+typedef void(*att_payload_cb_t)(uint16_t);
+
 // Enables the BLE stack.
 void ble_stack_enable(void);
 
@@ -34,6 +44,14 @@ void ble_connection_wait(void);
 // Registers the GAP and GATT BLE observers.
 void ble_observers_register(const nrf_sdh_ble_evt_handler_t ble_gap_obs_cb);
 
+/* Returns the largest payload a notification or write command can carry
+** on the current connection, ATT MTU minus the ATT header.
+*/
+uint16_t ble_att_payload_get(void);
+
+// Registers the function called when the ATT payload changes.
+void ble_att_payload_cb_register(att_payload_cb_t att_payload_cb);
+
 // Signals end of connection and goes in infinite loop.
 void connection_end_signal(void);
 
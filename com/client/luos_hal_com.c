@@ -9,6 +9,7 @@
 
 // NRF
 #include "ble_nus_c.h"                  // BLE_NUS_C_*, ble_nus_c_*
+#include "nrf_sdh_ble.h"                // NRF_SDH_BLE_OBSERVER
 #include "sdk_errors.h"                 // ret_code_t
 
 #ifdef DEBUG
@@ -18,48 +19,57 @@
 // NRF APPS
 #include "app_error.h"                  // APP_ERROR_CHECK
 
-// LUOS
-#include "context.h"                    // ctx
-#include "reception.h"                  // Recep_Timeout
+// SOFTDEVICE
+#include "ble.h"                        /* ble_evt_t,
+                                        ** BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE,
+                                        ** BLE_GAP_EVT_*
+                                        */
+#include "ble_gap.h"                    // ble_gap_conn_params_t
+#include "ble_types.h"                  // BLE_CONN_HANDLE_INVALID
 
 // CUSTOM
 #include "luos_hal_timer.h"             /* LuosHAL_TimeoutInit,
+                                        ** LuosHAL_TimeoutSetScale,
                                         ** DEFAULT_TIMEOUT
                                         */
 #include "luos_hal_ble_client_ctx.h"    // g_nus_c_ptr
-#include "msg_queue.h"                  // msg_queue_*, TX_BUF_SIZE
-
-/*      STATIC FUNCTIONS                                            */
-
-static inline void LuosHAL_ComReceive(void);
-
-// Sends the current buffer if needed and possible.
-static bool LuosHAL_ComSendOp(void);
+#include "luos_hal_com_common.h"        /* com_rx_packet, com_tx_*,
+                                        ** com_link_timing
+                                        */
+#include "luos_hal_probe.h"             // PROBE_*
 
 /*      CALLBACKS                                                   */
 
 /* DB discovery complete:   Assigns handles and enables notifications.
-** TX event:                Manage received data in LuosHAL_ComReceive.
+** TX event:                Manage received data in com_rx_packet.
+** Disconnected:            Forget the packets being sent.
 */
 static void LuosHAL_ComClientEventHandler(ble_nus_c_t* instance,
                                           const ble_nus_c_evt_t* event);
 
+/* Write commands sent: Send data if available.
+** Connection timing:   Scale the Luos timeout.
+*/
+static void LuosHAL_ComBleEventHandler(const ble_evt_t* event,
+                                       void* context);
+
 /*      GLOBAL/STATIC VARIABLES & CONSTANTS                         */
 
-// Current read byte.
-volatile static uint8_t s_curr_rx_byte;
+// BLE observer priority, same as the NUS client one.
+#define COM_OBS_PRIO    2
 
 // Global NUS client instance accessor.
 ble_nus_c_t*            g_nus_c_ptr;
 
-// Timeout to wait for resources.
-static const uint32_t   COM_TX_WAIT_RESOURCES   = 25;
-
 /*      INITIALIZATIONS                                             */
 
 // NUS client instance.
 BLE_NUS_C_DEF(s_nus_c);
 
+// BLE observer for write command completion.
+NRF_SDH_BLE_OBSERVER(s_com_obs, COM_OBS_PRIO,
+                     LuosHAL_ComBleEventHandler, NULL);
+
 /******************************************************************************
  * @brief Luos HAL Initialize Generale communication inter node
  * @param Select a baudrate for the Com
@@ -68,6 +78,8 @@ BLE_NUS_C_DEF(s_nus_c);
 void LuosHAL_ComInit(uint32_t Baudrate)
 {
     LuosHAL_TimeoutInit();
+    // Until a connection gives the actual timing.
+    LuosHAL_TimeoutSetScale(Baudrate, 0);
 
     ble_nus_c_init_t params;
     memset(&params, 0, sizeof(ble_nus_c_init_t));
@@ -79,6 +91,9 @@ void LuosHAL_ComInit(uint32_t Baudrate)
 
     // FIXME Read explanation in `luos_hal_ble_client_ctx.h`.
     g_nus_c_ptr = &s_nus_c;
+
+    com_tx_init(COM_WRITE_CMD_TX_QUEUE_SIZE);
+    com_rx_init();
 }
 /******************************************************************************
  * @brief Tx enable/disable relative to com
@@ -97,108 +112,6 @@ void LuosHAL_SetRxState(uint8_t Enable)
 {
 }
 
-/******************************************************************************
- * @brief Process data transmit
- * @param None
- * @return None
- ******************************************************************************/
-uint8_t LuosHAL_ComTransmit(uint8_t *data, uint16_t size)
-{
-    #ifdef DEBUG
-    NRF_LOG_INFO("Prepare %u bytes for sending!", size);
-    NRF_LOG_HEXDUMP_INFO(data, size);
-    #endif /* DEBUG */
-
-    if (size <= TX_BUF_SIZE)
-    {
-        bool enqueued = msg_queue_enqueue(data, size);
-        if (!enqueued)
-        {
-            #ifdef DEBUG
-            NRF_LOG_INFO("Message could not be enqueued!");
-            #endif /* DEBUG */
-
-            return 0;
-        }
-    }
-    else
-    {
-        uint16_t curr_idx   = 0;
-        uint16_t cp_size    = TX_BUF_SIZE;
-        while (curr_idx < size)
-        {
-            bool enqueued = msg_queue_enqueue(data + curr_idx, cp_size);
-            if (!enqueued)
-            {
-                #ifdef DEBUG
-                NRF_LOG_INFO("Message could not be enqueued!");
-                #endif /* DEBUG */
-
-                return 0;
-            }
-
-            curr_idx += TX_BUF_SIZE;
-            if ((size - curr_idx) >= TX_BUF_SIZE)
-            {
-                cp_size = TX_BUF_SIZE;
-            }
-            else
-            {
-                cp_size = size - curr_idx;
-            }
-        }
-    }
-
-    while (true)
-    {
-        bool message_present = LuosHAL_ComSendOp();
-        if (!message_present)
-        {
-            // Message queue empty.
-            break;
-        }
-
-        // Wait for resources to cool down... There is no TX complete.
-        uint32_t curr_tick  = LuosHAL_GetSystick();
-        uint32_t waited_ms  = 0;
-        while (waited_ms < COM_TX_WAIT_RESOURCES)
-        {
-            uint32_t old_val    = curr_tick;
-            curr_tick           = LuosHAL_GetSystick();
-            if (curr_tick < old_val)
-            {
-                // There was an overflow.
-                uint32_t remaining;
-                if (old_val < MAX_SYSTICK_MS_VAL)
-                {
-                    remaining = 0;
-                }
-                else
-                {
-                    remaining = (old_val - MAX_SYSTICK_MS_VAL);
-                }
-                waited_ms += (remaining + curr_tick);
-            }
-            else
-            {
-                waited_ms += (curr_tick - old_val);
-            }
-        }
-    }
-
-    LuosHAL_ResetTimeout(DEFAULT_TIMEOUT);
-
-    return 1;
-}
-/******************************************************************************
- * @brief Luos Tx communication complete
- * @param None
- * @return None
- ******************************************************************************/
-void LuosHAL_ComTxComplete(void)
-{
-    LuosHAL_ResetTimeout(DEFAULT_TIMEOUT);
-}
 /******************************************************************************
  * @brief set state of Txlock detection pin
  * @param None
@@ -229,43 +142,15 @@ void com_clock_enable(void)
 {
     // FIXME Enable COM clock.
 }
-void LUOS_COM_IRQHANDLER()
-{
-    LuosHAL_ComReceive();
-}
 
-/******************************************************************************
- * @brief Process data receive
- * @param None
- * @return None
- ******************************************************************************/
-static inline void LuosHAL_ComReceive(void)
+bool com_link_ready(void)
 {
-    ctx.rx.callback(&s_curr_rx_byte);
+    return (s_nus_c.conn_handle != BLE_CONN_HANDLE_INVALID);
 }
 
-static bool LuosHAL_ComSendOp(void)
+ret_code_t com_link_send(uint8_t* data, uint16_t size)
 {
-    tx_buffer_t* tx_buffer = msg_queue_peek();
-    if (tx_buffer == NULL)
-    {
-        // Queue was empty: no message to send.
-        return false;
-    }
-
-    uint16_t    size    = tx_buffer->size;
-    uint8_t*    data    = tx_buffer->buffer;
-
-    #ifdef DEBUG
-    NRF_LOG_INFO("Sending %u bytes to server!", size);
-    #endif /* DEBUG */
-
-    ret_code_t err_code = ble_nus_c_string_send(&s_nus_c, data, size);
-    APP_ERROR_CHECK(err_code);
-
-    msg_queue_pop();
-
-    return true;
+    return ble_nus_c_string_send(&s_nus_c, data, size);
 }
 
 static void LuosHAL_ComClientEventHandler(ble_nus_c_t* instance,
@@ -292,27 +177,39 @@ static void LuosHAL_ComClientEventHandler(ble_nus_c_t* instance,
         NRF_LOG_HEXDUMP_INFO(event->p_data, len);
         #endif /* DEBUG */
 
-        for (uint16_t rx_byte_idx = 0; rx_byte_idx < len; rx_byte_idx++)
-        {
-            s_curr_rx_byte = event->p_data[rx_byte_idx];
-            LUOS_COM_IRQHANDLER();
-        }
-        if (len == 1) // Ack
-        {
-            // Manage Ack: reset recep callback and pop TX task.
-            Recep_Timeout();
-        }
-        else if (len < BLE_NUS_MAX_DATA_LEN - 1)
-        {
-            // Complete message: no need to wait for the rest.
-            Recep_Reset();
-        }
-        else
-        {
-            // Else it's partial data...
-            LuosHAL_ResetTimeout(DEFAULT_TIMEOUT);
-        }
+        PROBE_START(PROBE_COM_RX_PACKET);
+        com_rx_packet(event->p_data, len);
+        PROBE_STOP(PROBE_COM_RX_PACKET);
+    }
+        break;
+    case BLE_NUS_C_EVT_DISCONNECTED:
+        com_tx_reset();
+        break;
+    default:
+        break;
     }
+}
+
+static void LuosHAL_ComBleEventHandler(const ble_evt_t* event,
+                                       void* context)
+{
+    const ble_gap_conn_params_t* conn_params;
+
+    switch (event->header.evt_id)
+    {
+    case BLE_GAP_EVT_CONNECTED:
+        conn_params = &event->evt.gap_evt.params.connected.conn_params;
+        com_link_timing(conn_params->max_conn_interval,
+                        conn_params->slave_latency);
+        break;
+    case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+        conn_params = &event->evt.gap_evt.params.conn_param_update.conn_params;
+        com_link_timing(conn_params->max_conn_interval,
+                        conn_params->slave_latency);
+        break;
+    case BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE:
+        com_tx_complete(
+            event->evt.gattc_evt.params.write_cmd_tx_complete.count);
         break;
     default:
         break;
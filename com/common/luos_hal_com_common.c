@@ -0,0 +1,1262 @@
+#include "luos_hal_com_common.h"
+
+/*      INCLUDES                                                    */
+
+#include "luos_hal.h"
+
+// C STANDARD
+#include <stdbool.h>        // bool
+#include <stdint.h>         // uint8_t, uint16_t, UINT8_MAX
+#include <string.h>         // memcpy
+
+// NRF
+#include "sdk_errors.h"     // ret_code_t
+
+#ifdef DEBUG
+#include "nrf_log.h"        // NRF_LOG_*
+#endif /* DEBUG */
+
+// NRF APPS
+#include "app_error.h"      // APP_ERROR_CHECK
+#include "app_timer.h"      // APP_TIMER_*, app_timer_*
+
+#if (COM_RX_DEFERRED == COM_RX_DEFER_SWI)
+#include "app_util_platform.h"  // APP_IRQ_PRIORITY_*
+#include "nrf_nvic.h"           // sd_nvic_*
+#elif (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+#include "app_scheduler.h"      // app_sched_event_put
+#endif /* COM_RX_DEFERRED */
+
+// LUOS
+#include "context.h"        // ctx
+#include "reception.h"      // Recep_Timeout, Recep_Reset
+
+#ifdef LUOS_COM_HOOKS_HEADER
+#include LUOS_COM_HOOKS_HEADER  // LUOS_COM_* hook declarations
+#endif /* LUOS_COM_HOOKS_HEADER */
+
+// CUSTOM
+#include "luos_hal_ble_common.h"    /* ble_att_payload_get,
+                                    ** ble_att_payload_cb_register,
+                                    ** ATT_PAYLOAD_MAX
+                                    */
+#include "luos_hal_com_queue.h"     // com_queue_*, com_tx_desc_t
+#include "luos_hal_probe.h"         // PROBE_*
+#include "luos_hal_com.h"           /* LuosHAL_ComGetRxCRC,
+                                    ** LuosHAL_ComGetFragmentSize,
+                                    ** com_stats_t
+                                    */
+#include "luos_hal_timer.h"         /* DEFAULT_TIMEOUT,
+                                    ** LuosHAL_TimeoutSetScale
+                                    */
+
+/*      STATIC FUNCTIONS                                            */
+
+// Queues a message in the given lane, see LuosHAL_ComTransmitLane.
+static uint8_t com_tx_enqueue(const com_segment_t* segments,
+                              uint8_t segment_nb, com_lane_t lane);
+
+/* Runs com_tx_pump, from any context: if it is already running, it is
+** asked to run once more instead.
+*/
+static void LuosHAL_ComSendOp(void);
+
+// Sends queued messages while the BLE stack accepts them.
+static void com_tx_pump(void);
+
+// Forgets the packets given to the BLE stack and the staged one.
+static void com_tx_reset_apply(void);
+
+/* Accounts for a packet refused by the BLE stack for lack of resources,
+** and starts the retry delay if no completion will come.
+*/
+static void com_tx_stall(void);
+
+// Starts the TX timer, or starts it again, to expire in the given ticks.
+static void com_tx_timer_start(uint32_t ticks);
+
+// Stops the TX timer if it runs.
+static void com_tx_timer_stop(void);
+
+/* Moves queued messages into the staged packet while they fit. Returns
+** false if the packet is full.
+*/
+static bool com_tx_packet_fill(void);
+
+/* Returns the next descriptor to stage and its lane: the message in
+** progress goes on, else the highest priority lane with a message.
+*/
+static com_tx_desc_t* com_tx_lane_peek(com_lane_t* lane);
+
+#if (COM_TX_COALESCING != DISABLE) && (COM_TX_FLUSH_DEADLINE != 0)
+/* Returns true if the staged packet should wait for more messages,
+** starting the flush deadline if needed.
+*/
+static bool com_tx_packet_hold(void);
+#endif /* COM_TX_COALESCING && COM_TX_FLUSH_DEADLINE */
+
+// Hands the records of a received packet to Luos.
+static void com_rx_process(const uint8_t* data, uint16_t size);
+
+#if (COM_RX_DEFERRED != DISABLE)
+// Processes the packets waiting in the RX queue.
+static void com_rx_drain(void);
+
+// Asks for com_rx_drain to run in the deferred context.
+static void com_rx_drain_request(void);
+#endif /* COM_RX_DEFERRED */
+
+// Hands a received record to Luos and follows the message boundaries.
+static void com_rx_record(uint8_t flags, const uint8_t* data, uint16_t size);
+
+#ifndef LUOS_COM_RX_BLOCK_HANDLER
+static inline void LuosHAL_ComReceive(void);
+#endif /* ! LUOS_COM_RX_BLOCK_HANDLER */
+
+// Hands the given buffer to the Luos reception.
+static inline void com_rx_deliver(const uint8_t* data, uint16_t size);
+
+// Hands a received ACK to Luos, out of any message.
+static void com_rx_ack(uint8_t ack);
+
+// Drops the current message before its end.
+static void com_rx_drop(void);
+
+// Ends the reception of the current message.
+static void com_rx_end(void);
+
+#if (COM_RX_FUSED_CRC != DISABLE)
+// Adds the given packet to the CRC of the current message.
+static void com_rx_crc_update(const uint8_t* data, uint16_t size);
+#endif /* COM_RX_FUSED_CRC */
+
+/*      CALLBACKS                                                   */
+
+// Scales the Luos timeout again when the ATT payload changes.
+static void com_link_payload_handler(uint16_t payload);
+
+/* Sends the staged packet when the flush deadline or the retry delay
+** expires.
+*/
+static void com_tx_timer_handler(void* context);
+
+#if (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+// Drains the RX queue from the main loop.
+static void com_rx_sched_handler(void* event_data, uint16_t event_size);
+#endif /* COM_RX_DEFERRED */
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
+/* Each packet is made of records, one per fragment:
+**      [flags][size][fragment data]
+** The flags tell where the fragment stands in its message, so that the
+** receiver knows a message is complete as soon as its end is received.
+*/
+#define COM_RECORD_HEADER_SIZE  2
+#define COM_RECORD_FLAGS_IDX    0
+#define COM_RECORD_SIZE_IDX     1
+#define COM_RECORD_SIZE_MAX     UINT8_MAX
+
+// app_timer ticks to microseconds.
+#define COM_TICKS_TO_US(ticks)  ((uint32_t)(((uint64_t)(ticks)           \
+                                * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1)   \
+                                * 1000000) / APP_TIMER_CLOCK_FREQ))
+
+// Microseconds to app_timer ticks, rounded up.
+#define COM_US_TO_TICKS(us)     (((uint64_t)(us) * APP_TIMER_CLOCK_FREQ   \
+                                 + (APP_TIMER_CONFIG_RTC_FREQUENCY + 1)  \
+                                 * 1000000 - 1)                          \
+                                / ((APP_TIMER_CONFIG_RTC_FREQUENCY + 1)  \
+                                   * 1000000))
+
+// Longest span the 24 bits app_timer counter can measure, in ticks.
+#define COM_TICKS_SPAN_MAX      0x7FFFFF
+
+// Record flags.
+#define COM_RECORD_START        0x01    // First fragment of a message
+#define COM_RECORD_END          0x02    // Last fragment of a message
+#define COM_RECORD_MSG          (COM_RECORD_START | COM_RECORD_END)
+
+// Luos ACKs are one byte messages.
+#define COM_ACK_SIZE            1
+
+// Connection interval unit, in microseconds.
+#define COM_CONN_INTERVAL_UNIT_US   1250
+
+// COM counters.
+static com_stats_t      s_com_stats;
+
+// Number of packets the BLE stack can queue.
+static uint8_t          s_link_queue_size   = 1;
+
+/* Connection interval (1.25 ms units) and peripheral latency, kept to
+** scale the timeout again on ATT MTU updates. 0 interval: no connection.
+*/
+static uint16_t         s_conn_interval     = 0;
+static uint16_t         s_conn_latency      = 0;
+
+// Number of packets queued in the BLE stack.
+static uint8_t          s_tx_in_flight      = 0;
+
+// Packets reported as sent by the BLE stack, not yet accounted for.
+static uint8_t          s_tx_done           = 0;
+
+// True from a packet refused by the BLE stack to the next accepted one.
+static bool             s_tx_stalled        = false;
+static uint32_t         s_tx_stall_tick     = 0;
+
+// Set when the pump must forget the packets in flight.
+static bool             s_tx_reset_pending  = false;
+
+// Set while the pump runs, and when it must run once more.
+static bool             s_tx_pump_busy      = false;
+static bool             s_tx_pump_pending   = false;
+
+// Packet being assembled, kept until the BLE stack accepts it.
+static uint8_t          s_tx_packet[ATT_PAYLOAD_MAX];
+static uint16_t         s_tx_packet_size    = 0;
+static uint8_t          s_tx_packet_records = 0;
+
+// Records of the staged packet holding a whole ACK.
+static uint8_t          s_tx_packet_acks    = 0;
+
+// True if the staged packet holds a control lane record.
+static bool             s_tx_packet_urgent  = false;
+
+// Last record of the staged packet if its message goes on, else NULL.
+static uint8_t*         s_tx_record         = NULL;
+
+// Lane of the message being staged, COM_LANE_NB between messages.
+static com_lane_t       s_tx_msg_lane       = COM_LANE_NB;
+
+// Zero copy messages are read in place: their queues need no arena.
+#if (COM_TX_ZERO_COPY == DISABLE)
+#define COM_TX_ARENA(SIZE)      (SIZE)
+#else
+#define COM_TX_ARENA(SIZE)      0
+#endif /* COM_TX_ZERO_COPY */
+
+// TX queues, one per lane.
+COM_QUEUE_DEF(s_tx_control_queue, COM_TX_CONTROL_QUEUE_SIZE,
+              COM_TX_ARENA(COM_TX_CONTROL_ARENA_SIZE));
+COM_QUEUE_DEF(s_tx_bulk_queue, COM_TX_MSG_QUEUE_SIZE,
+              COM_TX_ARENA(COM_TX_ARENA_SIZE));
+
+static com_queue_t* const s_tx_lanes[COM_LANE_NB] =
+{
+    [COM_LANE_CONTROL]  = &s_tx_control_queue,
+    [COM_LANE_BULK]     = &s_tx_bulk_queue,
+};
+
+/* True while the TX timer runs: flush deadline of the staged packet, or
+** retry delay of a packet refused with none in flight.
+*/
+static bool             s_tx_timer_armed    = false;
+
+#if (COM_TX_COALESCING != DISABLE) && (COM_TX_FLUSH_DEADLINE != 0)
+// True once the flush deadline of the staged packet expired.
+static bool             s_tx_flush_due      = false;
+#endif /* COM_TX_COALESCING && COM_TX_FLUSH_DEADLINE */
+
+#if (COM_RX_DEFERRED != DISABLE)
+/* Received packets waiting for Luos, filled by the BLE event handler and
+** drained by the deferred context.
+*/
+COM_QUEUE_DEF(s_rx_queue, COM_RX_QUEUE_SIZE, COM_RX_ARENA_SIZE);
+#endif /* COM_RX_DEFERRED */
+
+#if (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+// True while a drain waits in the app_scheduler queue.
+static bool             s_rx_drain_scheduled = false;
+#endif /* COM_RX_DEFERRED */
+
+#ifndef LUOS_COM_RX_BLOCK_HANDLER
+// Current read byte.
+volatile static uint8_t s_curr_rx_byte;
+#endif /* ! LUOS_COM_RX_BLOCK_HANDLER */
+
+#if (COM_RX_FUSED_CRC != DISABLE)
+// Initial value of a Luos message CRC.
+#define COM_RX_CRC_INIT 0xFFFF
+
+// CRC of the current message, trailing bytes excluded.
+static uint16_t s_rx_crc            = COM_RX_CRC_INIT;
+
+/* Last two received bytes: they are only added to the CRC once more
+** bytes are received, as the last two bytes of a message are its CRC.
+*/
+static uint8_t  s_rx_crc_tail[2];
+static uint8_t  s_rx_crc_tail_size  = 0;
+#endif /* COM_RX_FUSED_CRC */
+
+// Bytes of the current message received so far, 0 between messages.
+static uint16_t         s_rx_msg_size       = 0;
+
+#if (COM_RX_MSG_SIZE_MAX != 0)
+// Current message, and app_timer counter value when it started.
+static uint8_t          s_rx_msg[COM_RX_MSG_SIZE_MAX];
+static uint32_t         s_rx_msg_tick       = 0;
+
+// Reassembly deadline in app_timer ticks, scaled to the connection.
+static uint32_t         s_rx_msg_deadline   =
+    APP_TIMER_TICKS(COM_RX_MSG_DEADLINE);
+#endif /* COM_RX_MSG_SIZE_MAX */
+
+/*      INITIALIZATIONS                                             */
+
+// TX timer instance.
+APP_TIMER_DEF(s_tx_timer);
+
+/******************************************************************************
+ * @brief Process data transmit
+ * @param None
+ * @return None
+ ******************************************************************************/
+uint8_t LuosHAL_ComTransmit(uint8_t *data, uint16_t size)
+{
+    com_segment_t segment = { .data = data, .size = size };
+    return LuosHAL_ComTransmitV(&segment, 1);
+}
+
+uint8_t LuosHAL_ComTransmitV(const com_segment_t* segments,
+                             uint8_t segment_nb)
+{
+    uint16_t size = 0;
+    for (uint8_t seg_idx = 0; seg_idx < segment_nb; seg_idx++)
+    {
+        size += segments[seg_idx].size;
+    }
+
+    com_lane_t lane = COM_LANE_BULK;
+    if (size <= COM_TX_CONTROL_SIZE_MAX)
+    {
+        lane = COM_LANE_CONTROL;
+    }
+
+    return LuosHAL_ComTransmitLane(segments, segment_nb, lane);
+}
+
+uint8_t LuosHAL_ComTransmitLane(const com_segment_t* segments,
+                                uint8_t segment_nb, com_lane_t lane)
+{
+    PROBE_START(PROBE_COM_TRANSMIT);
+    uint8_t result = com_tx_enqueue(segments, segment_nb, lane);
+    PROBE_STOP(PROBE_COM_TRANSMIT);
+
+    return result;
+}
+
+static uint8_t com_tx_enqueue(const com_segment_t* segments,
+                              uint8_t segment_nb, com_lane_t lane)
+{
+    if (lane >= COM_LANE_NB)
+    {
+        LuosHAL_SetIrqState(false);
+        s_com_stats.tx_rejected++;
+        LuosHAL_SetIrqState(true);
+
+        #ifdef DEBUG
+        NRF_LOG_INFO("Unknown TX lane %u!", lane);
+        #endif /* DEBUG */
+
+        return 0;
+    }
+
+    com_queue_t* queue = s_tx_lanes[lane];
+
+    if (!com_link_ready())
+    {
+        #ifdef DEBUG
+        NRF_LOG_INFO("Link not ready: leaving...");
+        #endif /* DEBUG */
+
+        return 0;
+    }
+
+    uint16_t size = 0;
+    #if (COM_TX_ZERO_COPY != DISABLE)
+    // One descriptor per segment, read in place when staged.
+    uint8_t desc_nb = 0;
+    for (uint8_t seg_idx = 0; seg_idx < segment_nb; seg_idx++)
+    {
+        if (segments[seg_idx].size != 0)
+        {
+            desc_nb++;
+        }
+        size += segments[seg_idx].size;
+    }
+    uint16_t copy_size = 0;
+    #else
+    // One descriptor for the whole message, copied in the queue slots.
+    uint8_t desc_nb = 1;
+    for (uint8_t seg_idx = 0; seg_idx < segment_nb; seg_idx++)
+    {
+        size += segments[seg_idx].size;
+    }
+    uint16_t copy_size = size;
+    #endif /* COM_TX_ZERO_COPY */
+
+    /* Luos transmits both from its main loop and from the reception
+    ** callback, run in the BLE event interrupt: the lane producer side is
+    ** a critical section, from reserve to commit.
+    */
+    LuosHAL_SetIrqState(false);
+
+    if ((size == 0) || !com_queue_reserve(queue, desc_nb, copy_size))
+    {
+        s_com_stats.tx_rejected++;
+        LuosHAL_SetIrqState(true);
+
+        #ifdef DEBUG
+        NRF_LOG_INFO("Message could not be enqueued!");
+        #endif /* DEBUG */
+
+        return 0;
+    }
+
+    #if (COM_TX_ZERO_COPY != DISABLE)
+    uint8_t desc_idx = 0;
+    for (uint8_t seg_idx = 0; seg_idx < segment_nb; seg_idx++)
+    {
+        if (segments[seg_idx].size == 0)
+        {
+            continue;
+        }
+
+        com_tx_desc_t* desc = com_queue_reserved(queue, desc_idx);
+        desc->data = segments[seg_idx].data;
+        desc->size = segments[seg_idx].size;
+        if (desc_idx == 0)
+        {
+            desc->flags |= COM_QUEUE_MSG_START;
+        }
+        if (desc_idx == desc_nb - 1)
+        {
+            desc->flags |= COM_QUEUE_MSG_END;
+        }
+        desc_idx++;
+    }
+    #else
+    uint16_t offset = 0;
+    for (uint8_t seg_idx = 0; seg_idx < segment_nb; seg_idx++)
+    {
+        com_queue_copy(queue, offset, segments[seg_idx].data,
+                       segments[seg_idx].size);
+        offset += segments[seg_idx].size;
+    }
+
+    com_tx_desc_t* desc = com_queue_reserved(queue, 0);
+    desc->size  = size;
+    desc->flags = COM_QUEUE_MSG;
+    #endif /* COM_TX_ZERO_COPY */
+
+    com_queue_commit(queue);
+
+    LuosHAL_SetIrqState(true);
+
+    #ifdef DEBUG
+    NRF_LOG_INFO("Prepare %u bytes for sending!", size);
+    #endif /* DEBUG */
+
+    LuosHAL_ComSendOp();
+
+    LuosHAL_ResetTimeout(DEFAULT_TIMEOUT);
+
+    return 1;
+}
+/******************************************************************************
+ * @brief Luos Tx communication complete
+ * @param None
+ * @return None
+ ******************************************************************************/
+void LuosHAL_ComTxComplete(void)
+{
+    LuosHAL_ResetTimeout(DEFAULT_TIMEOUT);
+    LuosHAL_ComSendOp();
+}
+
+uint16_t LuosHAL_ComGetFragmentSize(void)
+{
+    uint16_t frag_size = ble_att_payload_get() - COM_RECORD_HEADER_SIZE;
+    if (frag_size > COM_RECORD_SIZE_MAX)
+    {
+        // Bounded by the record size field.
+        frag_size = COM_RECORD_SIZE_MAX;
+    }
+    return frag_size;
+}
+
+void com_tx_init(uint8_t link_queue_size)
+{
+    s_link_queue_size = link_queue_size;
+
+    // The ATT MTU is negotiated after the connection parameters.
+    ble_att_payload_cb_register(com_link_payload_handler);
+
+    ret_code_t err_code = app_timer_create(&s_tx_timer,
+                                           APP_TIMER_MODE_SINGLE_SHOT,
+                                           com_tx_timer_handler);
+    APP_ERROR_CHECK(err_code);
+}
+
+void com_tx_complete(uint8_t count)
+{
+    // Accounted for by the pump, which owns the TX state.
+    __atomic_fetch_add(&s_tx_done, count, __ATOMIC_RELAXED);
+
+    LuosHAL_ComTxComplete();
+}
+
+void com_tx_reset(void)
+{
+    __atomic_store_n(&s_tx_reset_pending, true, __ATOMIC_RELAXED);
+
+    LuosHAL_ComSendOp();
+}
+
+static void com_tx_reset_apply(void)
+{
+    s_tx_in_flight      = 0;
+    s_tx_stalled        = false;
+    s_tx_packet_size    = 0;
+    s_tx_packet_records = 0;
+    s_tx_packet_acks    = 0;
+    s_tx_packet_urgent  = false;
+    s_tx_record         = NULL;
+    s_tx_msg_lane       = COM_LANE_NB;
+
+    com_tx_timer_stop();
+}
+
+void com_rx_init(void)
+{
+    #if (COM_RX_DEFERRED == COM_RX_DEFER_SWI)
+    ret_code_t err_code = sd_nvic_SetPriority(COM_RX_SWI_IRQ, COM_RX_SWI_PRIO);
+    APP_ERROR_CHECK(err_code);
+    err_code = sd_nvic_ClearPendingIRQ(COM_RX_SWI_IRQ);
+    APP_ERROR_CHECK(err_code);
+    err_code = sd_nvic_EnableIRQ(COM_RX_SWI_IRQ);
+    APP_ERROR_CHECK(err_code);
+    #endif /* COM_RX_DEFERRED */
+}
+
+void com_link_timing(uint16_t conn_interval, uint16_t latency)
+{
+    s_conn_interval = conn_interval;
+    s_conn_latency  = latency;
+
+    com_link_payload_handler(ble_att_payload_get());
+}
+
+static void com_link_payload_handler(uint16_t payload)
+{
+    if (s_conn_interval == 0)
+    {
+        return;
+    }
+
+    const uint32_t interval_us = (uint32_t)s_conn_interval
+                                 * COM_CONN_INTERVAL_UNIT_US;
+
+    /* Data arrives in connection events: the bit time assumes a single
+    ** packet per event, and no timeout is shorter than a few events, the
+    ** peripheral being allowed to skip `latency` of them.
+    */
+    const uint32_t baudrate = (uint32_t)(((uint64_t)payload
+                                          * 8 * 1000000UL) / interval_us);
+    uint32_t       min_us   = COM_TIMEOUT_CONN_EVENTS * interval_us
+                              * ((uint32_t)s_conn_latency + 1);
+
+    #if (COM_TX_COALESCING != DISABLE) && (COM_TX_FLUSH_DEADLINE != 0)
+    // The peer may hold the end of a message up to its flush deadline.
+    if (min_us < COM_TX_FLUSH_DEADLINE * 1000UL)
+    {
+        min_us = COM_TX_FLUSH_DEADLINE * 1000UL;
+    }
+    #endif /* COM_TX_COALESCING && COM_TX_FLUSH_DEADLINE */
+
+    LuosHAL_TimeoutSetScale(baudrate, min_us);
+
+    #if (COM_RX_MSG_SIZE_MAX != 0)
+    /* The longest message comes in one fragment per packet, each of which
+    ** may take as long as the shortest Luos timeout.
+    */
+    const uint32_t fragment_size = payload - COM_RECORD_HEADER_SIZE;
+    const uint32_t fragment_nb   = (COM_RX_MSG_SIZE_MAX + fragment_size - 1)
+                                   / fragment_size;
+    uint64_t       deadline      = COM_US_TO_TICKS((uint64_t)fragment_nb
+                                                   * min_us);
+    if (deadline < APP_TIMER_TICKS(COM_RX_MSG_DEADLINE))
+    {
+        deadline = APP_TIMER_TICKS(COM_RX_MSG_DEADLINE);
+    }
+    if (deadline > COM_TICKS_SPAN_MAX)
+    {
+        deadline = COM_TICKS_SPAN_MAX;
+    }
+    s_rx_msg_deadline = (uint32_t)deadline;
+    #endif /* COM_RX_MSG_SIZE_MAX */
+}
+
+void com_rx_packet(const uint8_t* data, uint16_t size)
+{
+    s_com_stats.rx_packets++;
+
+    #if (COM_RX_DEFERRED != DISABLE)
+    if (!com_queue_reserve(&s_rx_queue, 1, size))
+    {
+        #ifdef DEBUG
+        NRF_LOG_INFO("RX queue full: dropping %u bytes!", size);
+        #endif /* DEBUG */
+
+        s_com_stats.rx_dropped++;
+        return;
+    }
+
+    com_queue_copy(&s_rx_queue, 0, data, size);
+    com_queue_reserved(&s_rx_queue, 0)->size = size;
+    com_queue_commit(&s_rx_queue);
+
+    com_rx_drain_request();
+    #else
+    PROBE_START(PROBE_COM_RX_PROCESS);
+    com_rx_process(data, size);
+    PROBE_STOP(PROBE_COM_RX_PROCESS);
+    #endif /* COM_RX_DEFERRED */
+}
+
+static void com_rx_process(const uint8_t* data, uint16_t size)
+{
+    uint16_t curr_idx = 0;
+    while (size - curr_idx >= COM_RECORD_HEADER_SIZE)
+    {
+        uint8_t flags       = data[curr_idx + COM_RECORD_FLAGS_IDX];
+        uint8_t record_size = data[curr_idx + COM_RECORD_SIZE_IDX];
+        curr_idx += COM_RECORD_HEADER_SIZE;
+
+        if ((record_size == 0) || (record_size > size - curr_idx))
+        {
+            break;
+        }
+
+        com_rx_record(flags, data + curr_idx, record_size);
+        curr_idx += record_size;
+    }
+
+    if (curr_idx != size)
+    {
+        #ifdef DEBUG
+        NRF_LOG_INFO("Malformed record: dropping the packet end!");
+        #endif /* DEBUG */
+    }
+}
+
+static void com_rx_record(uint8_t flags, const uint8_t* data, uint16_t size)
+{
+    if (flags & COM_RECORD_START)
+    {
+        if (s_rx_msg_size != 0)
+        {
+            // End of the previous message was lost: drop it.
+            com_rx_drop();
+        }
+
+        if ((flags & COM_RECORD_END) && (size == COM_ACK_SIZE))
+        {
+            // Whole ACK: no message to reassemble.
+            com_rx_ack(data[0]);
+            return;
+        }
+
+        #if (COM_RX_MSG_SIZE_MAX != 0)
+        s_rx_msg_tick = app_timer_cnt_get();
+        #endif /* COM_RX_MSG_SIZE_MAX */
+    }
+    else if (s_rx_msg_size == 0)
+    {
+        // Start of this message was lost: nothing to append to.
+        return;
+    }
+    #if (COM_RX_MSG_SIZE_MAX != 0)
+    else if (app_timer_cnt_diff_compute(app_timer_cnt_get(), s_rx_msg_tick)
+             > s_rx_msg_deadline)
+    {
+        // Too late: the rest of this message is dropped too.
+        s_com_stats.rx_msg_expired++;
+        com_rx_drop();
+        return;
+    }
+    #endif /* COM_RX_MSG_SIZE_MAX */
+
+    #if (COM_RX_FUSED_CRC != DISABLE)
+    com_rx_crc_update(data, size);
+    #endif /* COM_RX_FUSED_CRC */
+
+    #if (COM_RX_MSG_SIZE_MAX != 0)
+    if (size > sizeof(s_rx_msg) - s_rx_msg_size)
+    {
+        #ifdef DEBUG
+        NRF_LOG_INFO("Received message too long: dropping it!");
+        #endif /* DEBUG */
+
+        com_rx_drop();
+        return;
+    }
+    memcpy(s_rx_msg + s_rx_msg_size, data, size);
+    #else
+    com_rx_deliver(data, size);
+    #endif /* COM_RX_MSG_SIZE_MAX */
+
+    s_rx_msg_size += size;
+
+    if (!(flags & COM_RECORD_END))
+    {
+        #if (COM_RX_MSG_SIZE_MAX == 0)
+        // Partial message: wait for the rest.
+        LuosHAL_ResetTimeout(DEFAULT_TIMEOUT);
+        #endif /* ! COM_RX_MSG_SIZE_MAX */
+        return;
+    }
+
+    #if (COM_RX_MSG_SIZE_MAX != 0)
+    com_rx_deliver(s_rx_msg, s_rx_msg_size);
+    #endif /* COM_RX_MSG_SIZE_MAX */
+
+    s_com_stats.rx_messages++;
+    if (s_rx_msg_size > s_com_stats.rx_msg_size_max)
+    {
+        s_com_stats.rx_msg_size_max = s_rx_msg_size;
+    }
+
+    // Complete message: no need to wait for the timeout.
+    Recep_Reset();
+    com_rx_end();
+}
+
+const com_stats_t* LuosHAL_ComGetStats(void)
+{
+    for (uint8_t lane = 0; lane < COM_LANE_NB; lane++)
+    {
+        s_com_stats.lanes[lane].queue_max = com_queue_max(s_tx_lanes[lane]);
+        s_com_stats.lanes[lane].arena_max =
+            com_queue_arena_max(s_tx_lanes[lane]);
+    }
+
+    #if (COM_RX_DEFERRED != DISABLE)
+    s_com_stats.rx_queue_max = com_queue_max(&s_rx_queue);
+    s_com_stats.rx_arena_max = com_queue_arena_max(&s_rx_queue);
+    #endif /* COM_RX_DEFERRED */
+
+    return &s_com_stats;
+}
+
+uint16_t LuosHAL_ComGetRxCRC(void)
+{
+    #if (COM_RX_FUSED_CRC != DISABLE)
+    return s_rx_crc;
+    #else
+    return 0;
+    #endif /* COM_RX_FUSED_CRC */
+}
+
+#ifndef LUOS_COM_RX_BLOCK_HANDLER
+void LUOS_COM_IRQHANDLER()
+{
+    LuosHAL_ComReceive();
+}
+
+/******************************************************************************
+ * @brief Process data receive
+ * @param None
+ * @return None
+ ******************************************************************************/
+static inline void LuosHAL_ComReceive(void)
+{
+    ctx.rx.callback(&s_curr_rx_byte);
+}
+#endif /* ! LUOS_COM_RX_BLOCK_HANDLER */
+
+static inline void com_rx_deliver(const uint8_t* data, uint16_t size)
+{
+    #ifdef LUOS_COM_RX_BLOCK_HANDLER
+    LUOS_COM_RX_BLOCK_HANDLER(data, size);
+    #else
+    // Fallback: emulate a UART, one reception interrupt per byte.
+    for (uint16_t rx_byte_idx = 0; rx_byte_idx < size; rx_byte_idx++)
+    {
+        s_curr_rx_byte = data[rx_byte_idx];
+        LUOS_COM_IRQHANDLER();
+    }
+    #endif /* LUOS_COM_RX_BLOCK_HANDLER */
+}
+
+static void LuosHAL_ComSendOp(void)
+{
+    /* Messages are queued from the Luos loop, completions come from BLE
+    ** events and the TX timer from the app_timer: the pump is the
+    ** only consumer of the TX queues, without masking interrupts.
+    */
+    __atomic_store_n(&s_tx_pump_pending, true, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&s_tx_pump_pending, __ATOMIC_ACQUIRE)
+           && !__atomic_test_and_set(&s_tx_pump_busy, __ATOMIC_ACQUIRE))
+    {
+        while (__atomic_exchange_n(&s_tx_pump_pending, false,
+                                   __ATOMIC_ACQUIRE))
+        {
+            PROBE_START(PROBE_COM_SEND);
+            com_tx_pump();
+            PROBE_STOP(PROBE_COM_SEND);
+        }
+        __atomic_clear(&s_tx_pump_busy, __ATOMIC_RELEASE);
+    }
+}
+
+static void com_tx_pump(void)
+{
+    if (__atomic_exchange_n(&s_tx_reset_pending, false, __ATOMIC_ACQUIRE))
+    {
+        com_tx_reset_apply();
+    }
+
+    uint8_t done = __atomic_exchange_n(&s_tx_done, 0, __ATOMIC_ACQUIRE);
+    s_com_stats.tx_completed += done;
+    if (done > s_tx_in_flight)
+    {
+        done = s_tx_in_flight;
+    }
+    s_tx_in_flight -= done;
+
+    while (com_link_ready() && (s_tx_in_flight < s_link_queue_size))
+    {
+        bool queue_drained = com_tx_packet_fill();
+        if (s_tx_packet_size == 0)
+        {
+            // Queue was empty: no message to send.
+            return;
+        }
+
+        #if (COM_TX_ACK_PIGGYBACK != DISABLE)
+        if (queue_drained && (s_tx_in_flight != 0)
+            && (s_tx_packet_acks == s_tx_packet_records))
+        {
+            // Only ACKs: sent on next completion, with any new message.
+            return;
+        }
+        #endif /* COM_TX_ACK_PIGGYBACK */
+
+        #if (COM_TX_COALESCING != DISABLE) && (COM_TX_FLUSH_DEADLINE != 0)
+        if (queue_drained && com_tx_packet_hold())
+        {
+            // Sent on next completion or when the deadline expires.
+            return;
+        }
+        #else
+        (void)queue_drained;
+        #endif /* COM_TX_COALESCING && COM_TX_FLUSH_DEADLINE */
+
+        #ifdef DEBUG
+        NRF_LOG_INFO("Sending %u bytes in %u records!", s_tx_packet_size,
+                     s_tx_packet_records);
+        #endif /* DEBUG */
+
+        ret_code_t err_code = com_link_send(s_tx_packet, s_tx_packet_size);
+        if ((err_code == NRF_ERROR_RESOURCES) || (err_code == NRF_ERROR_BUSY))
+        {
+            // BLE stack busy: keep the packet, see com_tx_stall.
+            com_tx_stall();
+            return;
+        }
+        APP_ERROR_CHECK(err_code);
+
+        if (s_tx_stalled)
+        {
+            uint32_t stall_time =
+                COM_TICKS_TO_US(app_timer_cnt_diff_compute(app_timer_cnt_get(),
+                                                           s_tx_stall_tick));
+            if (stall_time > s_com_stats.tx_stall_time_max)
+            {
+                s_com_stats.tx_stall_time_max = stall_time;
+            }
+            s_tx_stalled = false;
+        }
+
+        s_tx_in_flight++;
+        s_com_stats.tx_packets++;
+        s_com_stats.tx_bytes    += s_tx_packet_size;
+        s_com_stats.tx_records  += s_tx_packet_records;
+        if (s_tx_in_flight > s_com_stats.tx_in_flight_max)
+        {
+            s_com_stats.tx_in_flight_max = s_tx_in_flight;
+        }
+
+        s_com_stats.tx_acks += s_tx_packet_acks;
+        if (s_tx_packet_records > s_tx_packet_acks)
+        {
+            s_com_stats.tx_acks_piggybacked += s_tx_packet_acks;
+        }
+
+        s_tx_packet_size    = 0;
+        s_tx_packet_records = 0;
+        s_tx_packet_acks    = 0;
+        s_tx_packet_urgent  = false;
+        s_tx_record         = NULL;
+
+        com_tx_timer_stop();
+    }
+}
+
+static void com_tx_stall(void)
+{
+    s_com_stats.tx_retries++;
+    if (!s_tx_stalled)
+    {
+        s_com_stats.tx_stalls++;
+        s_tx_stalled    = true;
+        s_tx_stall_tick = app_timer_cnt_get();
+    }
+
+    if (s_tx_in_flight == 0)
+    {
+        /* No completion to wait for: the BLE stack is busy with another
+        ** procedure, e.g. a GATT client one.
+        */
+        com_tx_timer_start(APP_TIMER_TICKS(COM_TX_RETRY_DELAY));
+    }
+}
+
+static void com_tx_timer_start(uint32_t ticks)
+{
+    // A single shot timer which fired is still seen as armed: stop it.
+    com_tx_timer_stop();
+
+    if (ticks < APP_TIMER_MIN_TIMEOUT_TICKS)
+    {
+        ticks = APP_TIMER_MIN_TIMEOUT_TICKS;
+    }
+
+    ret_code_t err_code = app_timer_start(s_tx_timer, ticks, NULL);
+    APP_ERROR_CHECK(err_code);
+    s_tx_timer_armed = true;
+}
+
+static void com_tx_timer_stop(void)
+{
+    if (s_tx_timer_armed)
+    {
+        ret_code_t err_code = app_timer_stop(s_tx_timer);
+        APP_ERROR_CHECK(err_code);
+    }
+    s_tx_timer_armed = false;
+
+    #if (COM_TX_COALESCING != DISABLE) && (COM_TX_FLUSH_DEADLINE != 0)
+    __atomic_store_n(&s_tx_flush_due, false, __ATOMIC_RELAXED);
+    #endif /* COM_TX_COALESCING && COM_TX_FLUSH_DEADLINE */
+}
+
+static bool com_tx_packet_fill(void)
+{
+    uint16_t packet_size_max = ble_att_payload_get();
+    if (packet_size_max > sizeof(s_tx_packet))
+    {
+        packet_size_max = sizeof(s_tx_packet);
+    }
+
+    com_lane_t      lane;
+    com_tx_desc_t*  desc;
+    while ((desc = com_tx_lane_peek(&lane)) != NULL)
+    {
+        /* The rest of the message in progress extends the last record of
+        ** the packet, saving a record header.
+        */
+        uint8_t*    record      = s_tx_record;
+        uint16_t    header_size = COM_RECORD_HEADER_SIZE;
+        uint16_t    record_room = COM_RECORD_SIZE_MAX;
+        if (record != NULL)
+        {
+            header_size = 0;
+            record_room = COM_RECORD_SIZE_MAX - record[COM_RECORD_SIZE_IDX];
+        }
+
+        #if (COM_TX_COALESCING == DISABLE)
+        if ((record == NULL) && (s_tx_packet_records != 0))
+        {
+            // One message per packet.
+            return false;
+        }
+        #endif /* ! COM_TX_COALESCING */
+
+        uint16_t room = packet_size_max - s_tx_packet_size;
+        if (room <= header_size)
+        {
+            // Packet full: the message goes on in the next one.
+            return false;
+        }
+
+        // Cut the fragment to what the packet and the record can take.
+        const uint8_t*  frag_data = desc->data + desc->staged;
+        uint16_t        frag_size = desc->size - desc->staged;
+        if (frag_size > room - header_size)
+        {
+            frag_size = room - header_size;
+        }
+        if (frag_size > record_room)
+        {
+            frag_size = record_room;
+        }
+        if (frag_size == 0)
+        {
+            // Record full: go on in a new one.
+            s_tx_record = NULL;
+            continue;
+        }
+
+        uint8_t flags = 0;
+        if ((desc->staged == 0) && (desc->flags & COM_QUEUE_MSG_START))
+        {
+            flags |= COM_RECORD_START;
+        }
+        desc->staged += frag_size;
+        if ((desc->staged >= desc->size) && (desc->flags & COM_QUEUE_MSG_END))
+        {
+            flags |= COM_RECORD_END;
+        }
+
+        if (record == NULL)
+        {
+            record = s_tx_packet + s_tx_packet_size;
+            record[COM_RECORD_FLAGS_IDX]    = 0;
+            record[COM_RECORD_SIZE_IDX]     = 0;
+            s_tx_packet_size += COM_RECORD_HEADER_SIZE;
+            s_tx_packet_records++;
+        }
+        record[COM_RECORD_FLAGS_IDX]    |= flags;
+        record[COM_RECORD_SIZE_IDX]     += frag_size;
+        memcpy(s_tx_packet + s_tx_packet_size, frag_data, frag_size);
+        s_tx_packet_size += frag_size;
+
+        s_tx_record = (flags & COM_RECORD_END) ? NULL : record;
+
+        if ((flags == COM_RECORD_MSG) && (frag_size == COM_ACK_SIZE))
+        {
+            s_tx_packet_acks++;
+        }
+
+        if (lane == COM_LANE_CONTROL)
+        {
+            s_tx_packet_urgent = true;
+        }
+
+        if (flags & COM_RECORD_START)
+        {
+            s_tx_msg_lane = lane;
+        }
+        if (flags & COM_RECORD_END)
+        {
+            // Other lanes may go on at this message boundary.
+            s_tx_msg_lane = COM_LANE_NB;
+
+            com_lane_stats_t* lane_stats = &s_com_stats.lanes[lane];
+            uint32_t latency = COM_TICKS_TO_US(
+                app_timer_cnt_diff_compute(app_timer_cnt_get(),
+                                           desc->commit_tick));
+            lane_stats->messages++;
+            lane_stats->latency_sum += latency;
+            if (latency > lane_stats->latency_max)
+            {
+                lane_stats->latency_max = latency;
+            }
+        }
+
+        if (desc->staged >= desc->size)
+        {
+            #if (COM_TX_ZERO_COPY != DISABLE)
+            // The staged packet holds a copy: Luos can reuse its buffer.
+            LUOS_COM_TX_RELEASE(desc->data);
+            #endif /* COM_TX_ZERO_COPY */
+
+            com_queue_pop(s_tx_lanes[lane]);
+        }
+    }
+
+    return true;
+}
+
+static com_tx_desc_t* com_tx_lane_peek(com_lane_t* lane)
+{
+    if (s_tx_msg_lane != COM_LANE_NB)
+    {
+        // Finish the message in progress first.
+        *lane = s_tx_msg_lane;
+        return com_queue_peek(s_tx_lanes[s_tx_msg_lane]);
+    }
+
+    for (*lane = 0; *lane < COM_LANE_NB; (*lane)++)
+    {
+        com_tx_desc_t* desc = com_queue_peek(s_tx_lanes[*lane]);
+        if (desc != NULL)
+        {
+            return desc;
+        }
+    }
+    return NULL;
+}
+
+#if (COM_TX_COALESCING != DISABLE) && (COM_TX_FLUSH_DEADLINE != 0)
+static bool com_tx_packet_hold(void)
+{
+    if ((s_tx_in_flight == 0) || s_tx_packet_urgent
+        || __atomic_load_n(&s_tx_flush_due, __ATOMIC_ACQUIRE))
+    {
+        // Link idle, deadline expired or control message: send now.
+        return false;
+    }
+
+    if (!s_tx_timer_armed)
+    {
+        com_tx_timer_start(APP_TIMER_TICKS(COM_TX_FLUSH_DEADLINE));
+    }
+
+    return true;
+}
+#endif /* COM_TX_COALESCING && COM_TX_FLUSH_DEADLINE */
+
+static void com_tx_timer_handler(void* context)
+{
+    (void)context;
+
+    #if (COM_TX_COALESCING != DISABLE) && (COM_TX_FLUSH_DEADLINE != 0)
+    __atomic_store_n(&s_tx_flush_due, true, __ATOMIC_RELEASE);
+    #endif /* COM_TX_COALESCING && COM_TX_FLUSH_DEADLINE */
+
+    LuosHAL_ComSendOp();
+}
+
+#if (COM_RX_DEFERRED != DISABLE)
+static void com_rx_drain(void)
+{
+    uint32_t        start_tick  = app_timer_cnt_get();
+    bool            drained     = false;
+    com_tx_desc_t*  desc;
+    while ((desc = com_queue_peek(&s_rx_queue)) != NULL)
+    {
+        PROBE_START(PROBE_COM_RX_PROCESS);
+        com_rx_process(desc->data, desc->size);
+        PROBE_STOP(PROBE_COM_RX_PROCESS);
+        com_queue_pop(&s_rx_queue);
+        drained = true;
+    }
+
+    if (drained)
+    {
+        s_com_stats.rx_batches++;
+        s_com_stats.rx_deferred_time +=
+            COM_TICKS_TO_US(app_timer_cnt_diff_compute(app_timer_cnt_get(),
+                                                       start_tick));
+    }
+}
+
+static void com_rx_drain_request(void)
+{
+    #if (COM_RX_DEFERRED == COM_RX_DEFER_SWI)
+    ret_code_t err_code = sd_nvic_SetPendingIRQ(COM_RX_SWI_IRQ);
+    APP_ERROR_CHECK(err_code);
+    #else
+    if (__atomic_test_and_set(&s_rx_drain_scheduled, __ATOMIC_ACQUIRE))
+    {
+        // Already scheduled: the drain will find this packet too.
+        return;
+    }
+
+    ret_code_t err_code = app_sched_event_put(NULL, 0, com_rx_sched_handler);
+    if (err_code != NRF_SUCCESS)
+    {
+        // Scheduler queue full: retried on next packet.
+        __atomic_clear(&s_rx_drain_scheduled, __ATOMIC_RELEASE);
+    }
+    #endif /* COM_RX_DEFERRED */
+}
+#endif /* COM_RX_DEFERRED */
+
+#if (COM_RX_DEFERRED == COM_RX_DEFER_SWI)
+void COM_RX_SWI_IRQHANDLER(void)
+{
+    com_rx_drain();
+}
+#elif (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+static void com_rx_sched_handler(void* event_data, uint16_t event_size)
+{
+    (void)event_data;
+    (void)event_size;
+
+    // Cleared first: packets received meanwhile schedule another drain.
+    __atomic_clear(&s_rx_drain_scheduled, __ATOMIC_RELEASE);
+
+    com_rx_drain();
+}
+#endif /* COM_RX_DEFERRED */
+
+static void com_rx_ack(uint8_t ack)
+{
+    s_com_stats.rx_acks++;
+
+    #ifdef LUOS_COM_RX_ACK_HANDLER
+    LUOS_COM_RX_ACK_HANDLER(ack);
+    #else
+    // Manage Ack: reset recep callback and pop TX task.
+    com_rx_deliver(&ack, COM_ACK_SIZE);
+    Recep_Timeout();
+    #endif /* LUOS_COM_RX_ACK_HANDLER */
+}
+
+static void com_rx_drop(void)
+{
+    s_com_stats.rx_msg_dropped++;
+
+    #if (COM_RX_MSG_SIZE_MAX == 0)
+    // Luos already got the start of the message.
+    Recep_Reset();
+    #endif /* ! COM_RX_MSG_SIZE_MAX */
+
+    com_rx_end();
+}
+
+static void com_rx_end(void)
+{
+    s_rx_msg_size = 0;
+
+    #if (COM_RX_FUSED_CRC != DISABLE)
+    s_rx_crc            = COM_RX_CRC_INIT;
+    s_rx_crc_tail_size  = 0;
+    #endif /* COM_RX_FUSED_CRC */
+}
+
+#if (COM_RX_FUSED_CRC != DISABLE)
+static void com_rx_crc_update(const uint8_t* data, uint16_t size)
+{
+    if (size >= sizeof(s_rx_crc_tail))
+    {
+        // Flush the previous tail, then everything but the new one.
+        LuosHAL_ComputeCRCBlock(s_rx_crc_tail, s_rx_crc_tail_size,
+                                (uint8_t*)&s_rx_crc);
+        LuosHAL_ComputeCRCBlock((uint8_t*)data,
+                                size - sizeof(s_rx_crc_tail),
+                                (uint8_t*)&s_rx_crc);
+
+        s_rx_crc_tail[0]    = data[size - 2];
+        s_rx_crc_tail[1]    = data[size - 1];
+        s_rx_crc_tail_size  = sizeof(s_rx_crc_tail);
+    }
+    else if (size == 1)
+    {
+        if (s_rx_crc_tail_size == sizeof(s_rx_crc_tail))
+        {
+            // Shift the tail by one byte.
+            LuosHAL_ComputeCRC(s_rx_crc_tail, (uint8_t*)&s_rx_crc);
+            s_rx_crc_tail[0] = s_rx_crc_tail[1];
+            s_rx_crc_tail_size--;
+        }
+        s_rx_crc_tail[s_rx_crc_tail_size] = data[0];
+        s_rx_crc_tail_size++;
+    }
+}
+#endif /* COM_RX_FUSED_CRC */
@@ -0,0 +1,51 @@
+#ifndef LUOS_HAL_COM_COMMON_H
+#define LUOS_HAL_COM_COMMON_H
+
+/*      INCLUDES                                                    */
+
+// C STANDARD
+#include <stdbool.h>        // bool
+#include <stdint.h>         // uint8_t, uint16_t
+
+// NRF
+#include "sdk_errors.h"     // ret_code_t
+
+/*      BACKEND FUNCTIONS                                           */
+
+// Returns true if packets can be sent to the peer.
+bool com_link_ready(void);
+
+/* Hands a packet to the BLE stack. Returns NRF_ERROR_RESOURCES or
+** NRF_ERROR_BUSY if it cannot take it yet.
+*/
+ret_code_t com_link_send(uint8_t* data, uint16_t size);
+
+/*      COMMON FUNCTIONS                                            */
+
+/* Sets the number of packets the BLE stack can queue for sending, and
+** follows the ATT MTU updates.
+*/
+void com_tx_init(uint8_t link_queue_size);
+
+// Accounts for packets sent by the BLE stack, then sends queued ones.
+void com_tx_complete(uint8_t count);
+
+// Forgets the packets queued in the BLE stack, on disconnection.
+void com_tx_reset(void);
+
+// Sets up the deferred RX context, if any.
+void com_rx_init(void);
+
+/* Scales the Luos timeout to the connection: interval in 1.25 ms units
+** and peripheral latency, in connection events. Scaled again on each ATT
+** MTU update.
+*/
+void com_link_timing(uint16_t conn_interval, uint16_t latency);
+
+/* Hands the records of a received BLE packet to Luos, resetting the
+** reception at each message end. In deferred RX mode, the packet is
+** copied and processed later, out of the calling interrupt.
+*/
+void com_rx_packet(const uint8_t* data, uint16_t size);
+
+#endif /* ! LUOS_HAL_COM_COMMON_H */
@@ -0,0 +1,178 @@
+#include "luos_hal_com_queue.h"
+
+/*      INCLUDES                                                    */
+
+// C STANDARD
+#include <stdbool.h>        // bool
+#include <stdint.h>         // uint8_t, uint16_t
+#include <stddef.h>         // NULL
+#include <string.h>         // memcpy
+
+// NRF APPS
+#include "app_timer.h"      // app_timer_cnt_get
+
+/*      STATIC FUNCTIONS                                            */
+
+// Index shared with the other side, read after its writes.
+#define COM_QUEUE_ACQUIRE(index)        __atomic_load_n(&(index),          \
+                                                        __ATOMIC_ACQUIRE)
+
+// Own index, published once the entries it covers are written.
+#define COM_QUEUE_RELEASE(index, val)   __atomic_store_n(&(index), (val),  \
+                                                         __ATOMIC_RELEASE)
+
+bool com_queue_reserve(com_queue_t* queue, uint8_t desc_nb,
+                       uint16_t copy_size)
+{
+    uint8_t desc_head   = COM_QUEUE_ACQUIRE(queue->desc_head);
+    uint8_t desc_used   = (queue->desc_tail + queue->desc_size - desc_head)
+                          % queue->desc_size;
+    if (desc_nb > queue->desc_size - 1 - desc_used)
+    {
+        return false;
+    }
+
+    #if (COM_QUEUE_ARENA != DISABLE)
+    uint16_t arena_head = COM_QUEUE_ACQUIRE(queue->arena_head);
+    uint16_t arena_free = (arena_head + queue->arena_size - 1
+                           - queue->arena_tail) % queue->arena_size;
+    uint16_t copy_start = queue->arena_tail;
+    uint16_t arena_size = copy_size;
+    if (copy_size > queue->arena_size - queue->arena_tail)
+    {
+        // Not enough room before the end: skip it.
+        copy_start = 0;
+        arena_size += queue->arena_size - queue->arena_tail;
+    }
+    if (arena_size > arena_free)
+    {
+        return false;
+    }
+
+    queue->arena_reserved   = arena_size;
+    queue->arena_copy       = &queue->arena[copy_start];
+    queue->arena_copy_end   = copy_start + copy_size;
+
+    uint16_t arena_used = queue->arena_size - 1 - arena_free + arena_size;
+    if (arena_used > queue->arena_max)
+    {
+        queue->arena_max = arena_used;
+    }
+    #else
+    (void)copy_size;
+    #endif /* COM_QUEUE_ARENA */
+
+    queue->desc_reserved = desc_nb;
+    if (desc_used + desc_nb > queue->desc_max)
+    {
+        queue->desc_max = desc_used + desc_nb;
+    }
+
+    for (uint8_t desc_idx = 0; desc_idx < desc_nb; desc_idx++)
+    {
+        com_tx_desc_t* desc = com_queue_reserved(queue, desc_idx);
+        desc->data          = NULL;
+        desc->size          = 0;
+        desc->staged        = 0;
+        desc->flags         = 0;
+        desc->arena_size    = 0;
+    }
+
+    #if (COM_QUEUE_ARENA != DISABLE)
+    if ((desc_nb != 0) && (copy_size != 0))
+    {
+        com_tx_desc_t* desc = com_queue_reserved(queue, 0);
+        desc->data          = queue->arena_copy;
+        desc->arena_size    = arena_size;
+    }
+    #endif /* COM_QUEUE_ARENA */
+
+    return true;
+}
+
+com_tx_desc_t* com_queue_reserved(com_queue_t* queue, uint8_t idx)
+{
+    return &queue->descs[(queue->desc_tail + idx) % queue->desc_size];
+}
+
+void com_queue_copy(com_queue_t* queue, uint16_t offset,
+                    const uint8_t* data, uint16_t size)
+{
+    #if (COM_QUEUE_ARENA != DISABLE)
+    memcpy(queue->arena_copy + offset, data, size);
+    #else
+    (void)queue;
+    (void)offset;
+    (void)data;
+    (void)size;
+    #endif /* COM_QUEUE_ARENA */
+}
+
+void com_queue_commit(com_queue_t* queue)
+{
+    uint32_t commit_tick = app_timer_cnt_get();
+    for (uint8_t desc_idx = 0; desc_idx < queue->desc_reserved; desc_idx++)
+    {
+        com_queue_reserved(queue, desc_idx)->commit_tick = commit_tick;
+    }
+
+    #if (COM_QUEUE_ARENA != DISABLE)
+    // Arena bytes first: they are only reached through the descriptors.
+    if (queue->arena_reserved != 0)
+    {
+        COM_QUEUE_RELEASE(queue->arena_tail,
+                          queue->arena_copy_end % queue->arena_size);
+        queue->arena_reserved = 0;
+    }
+    #endif /* COM_QUEUE_ARENA */
+
+    COM_QUEUE_RELEASE(queue->desc_tail,
+                      (queue->desc_tail + queue->desc_reserved)
+                      % queue->desc_size);
+    queue->desc_reserved = 0;
+}
+
+com_tx_desc_t* com_queue_peek(com_queue_t* queue)
+{
+    if (queue->desc_head == COM_QUEUE_ACQUIRE(queue->desc_tail))
+    {
+        return NULL;
+    }
+    return &queue->descs[queue->desc_head];
+}
+
+void com_queue_pop(com_queue_t* queue)
+{
+    if (queue->desc_head == COM_QUEUE_ACQUIRE(queue->desc_tail))
+    {
+        return;
+    }
+
+    #if (COM_QUEUE_ARENA != DISABLE)
+    uint16_t arena_size = queue->descs[queue->desc_head].arena_size;
+    if (arena_size != 0)
+    {
+        COM_QUEUE_RELEASE(queue->arena_head,
+                          (queue->arena_head + arena_size)
+                          % queue->arena_size);
+    }
+    #endif /* COM_QUEUE_ARENA */
+
+    COM_QUEUE_RELEASE(queue->desc_head,
+                      (queue->desc_head + 1) % queue->desc_size);
+}
+
+uint8_t com_queue_max(const com_queue_t* queue)
+{
+    return queue->desc_max;
+}
+
+uint16_t com_queue_arena_max(const com_queue_t* queue)
+{
+    #if (COM_QUEUE_ARENA != DISABLE)
+    return queue->arena_max;
+    #else
+    (void)queue;
+    return 0;
+    #endif /* COM_QUEUE_ARENA */
+}
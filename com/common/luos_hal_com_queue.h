@@ -0,0 +1,156 @@
+#ifndef LUOS_HAL_COM_QUEUE_H
+#define LUOS_HAL_COM_QUEUE_H
+
+/*      INCLUDES                                                    */
+
+#include "luos_hal.h"
+
+// C STANDARD
+#include <stdbool.h>        // bool
+#include <stdint.h>         // uint8_t, uint16_t, uint32_t
+
+/*      CONSTANTS                                                   */
+
+// Queues hold an arena unless the zero copy TX queues are the only ones.
+#if (COM_TX_ZERO_COPY == DISABLE) || (COM_RX_DEFERRED != DISABLE)
+#define COM_QUEUE_ARENA     ENABLE
+#else
+#define COM_QUEUE_ARENA     DISABLE
+#endif
+
+// Descriptor flags.
+#define COM_QUEUE_MSG_START 0x01    // Descriptor opens a message
+#define COM_QUEUE_MSG_END   0x02    // Descriptor closes a message
+#define COM_QUEUE_MSG       (COM_QUEUE_MSG_START | COM_QUEUE_MSG_END)
+
+/*      TYPES                                                       */
+
+/* Message, or part of a message, waiting to be sent, or received packet
+** waiting to be processed.
+*/
+typedef struct
+{
+    // Bytes to process, in the Luos buffer or in the queue arena.
+    const uint8_t*  data;
+
+    // Number of bytes to process.
+    uint16_t        size;
+
+    // Bytes already staged for sending.
+    uint16_t        staged;
+
+    // COM_QUEUE_MSG_* flags.
+    uint8_t         flags;
+
+    // Arena bytes freed with the descriptor, skipped ones included.
+    uint16_t        arena_size;
+
+    // app_timer counter value when the descriptor was committed.
+    uint32_t        commit_tick;
+} com_tx_desc_t;
+
+/* Queue, to be defined with COM_QUEUE_DEF. It is a lock free single
+** producer, single consumer ring: each side only writes its own index,
+** published with release semantics and read with acquire semantics by
+** the other side. One descriptor and one arena byte are always left free
+** to tell a full ring from an empty one.
+** The consumer side, peek and pop, must be called from one context at a
+** time. So must the producer side, reserve to commit, taken as a whole:
+** producers running in several contexts, as the TX lanes fed from both
+** the Luos main loop and the BLE event interrupt, serialize it in a
+** LuosHAL_SetIrqState critical section.
+*/
+typedef struct
+{
+    // Queued descriptors, from desc_head (consumer) to desc_tail (producer).
+    com_tx_desc_t*  descs;
+    uint8_t         desc_size;
+    uint8_t         desc_head;
+    uint8_t         desc_tail;
+    uint8_t         desc_max;
+
+    // Descriptors reserved after the queued ones.
+    uint8_t         desc_reserved;
+
+    #if (COM_QUEUE_ARENA != DISABLE)
+    /* Bytes of the queued messages, each one contiguous and in queue
+    ** order, from arena_head (consumer) to arena_tail (producer). A
+    ** message that does not fit before the end of the arena starts over
+    ** at its beginning, the skipped bytes being freed along with it.
+    */
+    uint8_t*        arena;
+    uint16_t        arena_size;
+    uint16_t        arena_head;
+    uint16_t        arena_tail;
+    uint16_t        arena_max;
+
+    /* Arena bytes reserved, skipped ones included, and where the copy
+    ** starts and ends.
+    */
+    uint16_t        arena_reserved;
+    uint8_t*        arena_copy;
+    uint16_t        arena_copy_end;
+    #endif /* COM_QUEUE_ARENA */
+} com_queue_t;
+
+#if (COM_QUEUE_ARENA != DISABLE)
+// Defines a queue of desc_nb descriptors and arena_nb arena bytes.
+#define COM_QUEUE_DEF(name, desc_nb, arena_nb)                      \
+static com_tx_desc_t    name##_descs[(desc_nb) + 1];                \
+static uint8_t          name##_arena[(arena_nb) + 1];               \
+static com_queue_t      name =                                      \
+{                                                                   \
+    .descs      = name##_descs,                                     \
+    .desc_size  = (desc_nb) + 1,                                    \
+    .arena      = name##_arena,                                     \
+    .arena_size = (arena_nb) + 1,                                   \
+}
+#else
+#define COM_QUEUE_DEF(name, desc_nb, arena_nb)                      \
+static com_tx_desc_t    name##_descs[(desc_nb) + 1];                \
+static com_queue_t      name =                                      \
+{                                                                   \
+    .descs      = name##_descs,                                     \
+    .desc_size  = (desc_nb) + 1,                                    \
+}
+#endif /* COM_QUEUE_ARENA */
+
+/*      FUNCTIONS                                                   */
+
+// Producer side.
+
+/* Reserves desc_nb descriptors and copy_size contiguous arena bytes, all
+** at once: returns false, reserving nothing, if any does not fit. The
+** arena bytes go to the first descriptor. Reserved descriptors are only
+** seen by com_queue_peek once committed.
+** Being contiguous, copy_size is only sure to fit once the queue drains
+** if it is at most half the arena_nb bytes given to COM_QUEUE_DEF.
+*/
+bool com_queue_reserve(com_queue_t* queue, uint8_t desc_nb,
+                       uint16_t copy_size);
+
+// Returns the reserved descriptor of the given index.
+com_tx_desc_t* com_queue_reserved(com_queue_t* queue, uint8_t idx);
+
+// Copies bytes at the given offset of the reserved arena bytes.
+void com_queue_copy(com_queue_t* queue, uint16_t offset,
+                    const uint8_t* data, uint16_t size);
+
+// Makes the reserved descriptors available for sending.
+void com_queue_commit(com_queue_t* queue);
+
+// Consumer side.
+
+// Returns the oldest queued descriptor, NULL if the queue is empty.
+com_tx_desc_t* com_queue_peek(com_queue_t* queue);
+
+// Removes the oldest queued descriptor, freeing its arena bytes.
+void com_queue_pop(com_queue_t* queue);
+
+/* Highest number of descriptors and arena bytes used at once, to size
+** the queue. Updated by the producer.
+*/
+uint8_t com_queue_max(const com_queue_t* queue);
+uint16_t com_queue_arena_max(const com_queue_t* queue);
+
+#endif /* ! LUOS_HAL_COM_QUEUE_H */
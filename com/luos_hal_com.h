@@ -0,0 +1,148 @@
+#ifndef LUOS_HAL_COM_H
+#define LUOS_HAL_COM_H
+
+#include <stdint.h> // uint8_t, uint16_t, uint32_t, uint64_t
+
+// TX priority lanes, highest priority first.
+typedef enum
+{
+    COM_LANE_CONTROL,   // ACKs and short control messages
+    COM_LANE_BULK,      // Everything else
+    COM_LANE_NB
+} com_lane_t;
+
+// Counters of a TX lane.
+typedef struct
+{
+    // Messages fully handed to the BLE stack.
+    uint32_t    messages;
+
+    /* Time (us) from queuing to hand over to the BLE stack: longest, and
+    ** sum over all messages for the mean.
+    */
+    uint32_t    latency_max;
+    uint64_t    latency_sum;
+
+    // Highest number of queue arena bytes used at once.
+    uint16_t    arena_max;
+
+    // Highest number of queue descriptors used at once.
+    uint8_t     queue_max;
+} com_lane_stats_t;
+
+// BLE COM counters, never reset.
+typedef struct
+{
+    // Packets accepted by the BLE stack.
+    uint32_t    tx_packets;
+
+    // Payload bytes accepted by the BLE stack, record headers included.
+    uint32_t    tx_bytes;
+
+    /* Queued buffers sent: tx_records / tx_packets is the number of
+    ** messages packed per packet.
+    */
+    uint32_t    tx_records;
+
+    /* Messages rejected because the TX queue was full, or they were
+    ** empty or given an unknown lane.
+    */
+    uint32_t    tx_rejected;
+
+    // Packets reported as sent by the BLE stack.
+    uint32_t    tx_completed;
+
+    // Highest number of packets queued in the BLE stack at once.
+    uint8_t     tx_in_flight_max;
+
+    /* Packets refused by the BLE stack for lack of resources, each one
+    ** retried on a later TX complete event.
+    */
+    uint32_t    tx_retries;
+
+    /* Times sending stopped on such a refusal, and longest time (us)
+    ** until the BLE stack accepted a packet again.
+    */
+    uint32_t    tx_stalls;
+    uint32_t    tx_stall_time_max;
+
+    /* ACKs sent, and those sharing their packet with other messages
+    ** instead of taking a notification of their own.
+    */
+    uint32_t    tx_acks;
+    uint32_t    tx_acks_piggybacked;
+
+    // ACKs received.
+    uint32_t    rx_acks;
+
+    // Packets received.
+    uint32_t    rx_packets;
+
+    // Messages handed to Luos, ACKs excluded, and the longest one.
+    uint32_t    rx_messages;
+    uint16_t    rx_msg_size_max;
+
+    /* Messages dropped before their end: lost start or end, too long, or
+    ** past their deadline, the latter also counted in rx_msg_expired.
+    */
+    uint32_t    rx_msg_dropped;
+    uint32_t    rx_msg_expired;
+
+    // Packets dropped because the RX queue was full, in deferred mode.
+    uint32_t    rx_dropped;
+
+    /* Queue drains in deferred mode: rx_packets / rx_batches is the
+    ** number of packets processed per drain.
+    */
+    uint32_t    rx_batches;
+
+    /* Time (us) spent processing received packets out of the SoftDevice
+    ** event interrupt in deferred mode, with the app_timer resolution.
+    */
+    uint64_t    rx_deferred_time;
+
+    // Highest number of packets, and of bytes, in the RX queue at once.
+    uint16_t    rx_arena_max;
+    uint8_t     rx_queue_max;
+
+    // Per lane counters.
+    com_lane_stats_t lanes[COM_LANE_NB];
+} com_stats_t;
+
+// Piece of a message given to LuosHAL_ComTransmitV.
+typedef struct
+{
+    const uint8_t*  data;
+    uint16_t        size;
+} com_segment_t;
+
+/* Sends the concatenation of the given segments as one message, e.g.
+** header, payload and CRC, without assembling it in a single buffer.
+** Messages up to COM_TX_CONTROL_SIZE_MAX bytes go in the control lane.
+** Returns 1 if the message was queued, as LuosHAL_ComTransmit.
+*/
+uint8_t LuosHAL_ComTransmitV(const com_segment_t* segments,
+                             uint8_t segment_nb);
+
+/* Same as LuosHAL_ComTransmitV, in the given lane. Returns 0 for an
+** unknown lane.
+*/
+uint8_t LuosHAL_ComTransmitLane(const com_segment_t* segments,
+                                uint8_t segment_nb, com_lane_t lane);
+
+/* Returns the COM counters: sampling tx_bytes at two instants gives the
+** throughput.
+*/
+const com_stats_t* LuosHAL_ComGetStats(void);
+
+/* Largest fragment of a message a packet can carry: the payload
+** negotiated for the BLE connection minus the record header.
+*/
+uint16_t LuosHAL_ComGetFragmentSize(void);
+
+/* CRC of the message being received, its two trailing CRC bytes
+** excluded. Only maintained when COM_RX_FUSED_CRC is enabled.
+*/
+uint16_t LuosHAL_ComGetRxCRC(void);
+
+#endif /* ! LUOS_HAL_COM_H */
@@ -68,5 +68,190 @@ void com_irq_handler(void);
 #define LUOS_COM_IRQHANDLER()   com_irq_handler()
 #endif
 
+/*******************************************************************************
+ * BLE COM CONFIG
+ ******************************************************************************/
+/* Computes the CRC of received messages in the HAL, one notification at
+** a time, see LuosHAL_ComGetRxCRC.
+*/
+#ifndef COM_RX_FUSED_CRC
+#define COM_RX_FUSED_CRC        DISABLE
+#endif
+
+/* Reassembles each received message in a buffer of this many bytes and
+** hands it to Luos in one go once complete. Longer messages are dropped.
+** 0 hands the records to Luos as they arrive.
+*/
+#ifndef COM_RX_MSG_SIZE_MAX
+#define COM_RX_MSG_SIZE_MAX     512
+#endif
+
+/* Shortest time (ms) allowed from the first to the last record of a
+** reassembled message. Once connected, the deadline is scaled to the
+** link: the shortest Luos timeout, see COM_TIMEOUT_CONN_EVENTS, per
+** fragment of a COM_RX_MSG_SIZE_MAX bytes message. A message still
+** incomplete past it is dropped when its next record arrives: no timer
+** is restarted per packet.
+*/
+#ifndef COM_RX_MSG_DEADLINE
+#define COM_RX_MSG_DEADLINE     100
+#endif
+
+/* Shortest Luos timeout, in connection events: a stalled transfer is only
+** detected once that many events brought nothing.
+*/
+#ifndef COM_TIMEOUT_CONN_EVENTS
+#define COM_TIMEOUT_CONN_EVENTS 4
+#endif
+
+/* Number of notifications the SoftDevice can queue per connection: the
+** server keeps up to this many in flight. Each one costs SoftDevice RAM
+** (see the RAM start reported by nrf_sdh_ble_enable).
+*/
+#ifndef COM_HVN_TX_QUEUE_SIZE
+#define COM_HVN_TX_QUEUE_SIZE   4
+#endif
+
+// Same for the write commands sent by the client.
+#ifndef COM_WRITE_CMD_TX_QUEUE_SIZE
+#define COM_WRITE_CMD_TX_QUEUE_SIZE 4
+#endif
+
+/* Packs several queued messages in each BLE packet. Receivers always
+** accept packed packets.
+*/
+#ifndef COM_TX_COALESCING
+#define COM_TX_COALESCING       ENABLE
+#endif
+
+/* Longest time (ms) a partially filled packet waits for more messages
+** while previous packets are being sent. 0 never waits: messages are
+** then only packed when the BLE stack queue is full. The Luos timeout is
+** never shorter than this deadline.
+*/
+#ifndef COM_TX_FLUSH_DEADLINE
+#define COM_TX_FLUSH_DEADLINE   0
+#endif
+
+/* Time (ms) before sending again a packet refused by the BLE stack while
+** none is in flight, e.g. during a GATT client procedure: no completion
+** event comes to retry it.
+*/
+#ifndef COM_TX_RETRY_DELAY
+#define COM_TX_RETRY_DELAY      5
+#endif
+
+/* Number of bulk messages that can wait to be sent. In zero copy mode,
+** each segment given to LuosHAL_ComTransmitV counts as a message.
+*/
+#ifndef COM_TX_MSG_QUEUE_SIZE
+#define COM_TX_MSG_QUEUE_SIZE   16
+#endif
+
+/* Bytes available for the bulk messages waiting to be sent, out of zero
+** copy mode. Each message only takes its own size: see the arena_max
+** lane counter to size it.
+*/
+#ifndef COM_TX_ARENA_SIZE
+#define COM_TX_ARENA_SIZE       2048
+#endif
+
+/* Messages up to this size, such as Luos ACKs and detection messages,
+** go in the control lane: they are sent before any queued bulk message,
+** with their own queue and arena.
+*/
+#ifndef COM_TX_CONTROL_SIZE_MAX
+#define COM_TX_CONTROL_SIZE_MAX     16
+#endif
+#ifndef COM_TX_CONTROL_QUEUE_SIZE
+#define COM_TX_CONTROL_QUEUE_SIZE   8
+#endif
+#ifndef COM_TX_CONTROL_ARENA_SIZE
+#define COM_TX_CONTROL_ARENA_SIZE   128
+#endif
+
+/* Header declaring the Luos functions used by the LUOS_COM_* hooks below,
+** included by the COM layer, e.g.
+** #define LUOS_COM_HOOKS_HEADER "msg_alloc.h"
+** Without it, the hooks must only use functions declared by the headers
+** the COM layer already includes.
+*/
+
+/* Reads outgoing messages in place when packets are built, instead of
+** first copying them in the message queue, e.g.
+** #define LUOS_COM_TX_RELEASE(DATA) MsgAlloc_TxRelease(DATA)
+** This hook is required: it is called once the last byte of a message is
+** copied in the packet being built, not once the packet is sent, and Luos
+** may reuse the buffer from then on. The buffers given to
+** LuosHAL_ComTransmit must stay valid until then.
+**
+** Each byte sent is then copied twice, as with the original driver: in
+** the packet, then by the SoftDevice. Out of zero copy mode, it is first
+** copied in the message queue, three copies in total.
+*/
+#ifndef COM_TX_ZERO_COPY
+#define COM_TX_ZERO_COPY        DISABLE
+#endif
+#if (COM_TX_ZERO_COPY != DISABLE) && !defined(LUOS_COM_TX_RELEASE)
+#error "COM_TX_ZERO_COPY requires LUOS_COM_TX_RELEASE."
+#endif
+
+/* Keeps a packet holding only ACKs while previous packets are being sent,
+** so that the ACKs ride along with the data queued before the next
+** completion instead of taking a notification of their own. Delays them
+** by up to one connection interval.
+*/
+#ifndef COM_TX_ACK_PIGGYBACK
+#define COM_TX_ACK_PIGGYBACK    DISABLE
+#endif
+
+/* Processes received packets out of the SoftDevice event interrupt: the
+** BLE event handler only copies them in a queue, drained in batches by
+**  - COM_RX_DEFER_SWI:   a software interrupt at a lower priority,
+**  - COM_RX_DEFER_SCHED: the app_scheduler, from the main loop.
+*/
+#define COM_RX_DEFER_SWI        0x01
+#define COM_RX_DEFER_SCHED      0x02
+
+#ifndef COM_RX_DEFERRED
+#define COM_RX_DEFERRED         DISABLE
+#endif
+
+// Number of received packets, and their total bytes, waiting for Luos.
+#ifndef COM_RX_QUEUE_SIZE
+#define COM_RX_QUEUE_SIZE       8
+#endif
+
+#ifndef COM_RX_ARENA_SIZE
+#define COM_RX_ARENA_SIZE       1024
+#endif
+
+// Software interrupt draining the queue, unused by the SoftDevice.
+#ifndef COM_RX_SWI_IRQ
+#define COM_RX_SWI_IRQ          SWI3_EGU3_IRQn
+#endif
+
+#ifndef COM_RX_SWI_IRQHANDLER
+#define COM_RX_SWI_IRQHANDLER   SWI3_EGU3_IRQHandler
+#endif
+
+#ifndef COM_RX_SWI_PRIO
+#define COM_RX_SWI_PRIO         APP_IRQ_PRIORITY_LOWEST
+#endif
+
+/* Luos reception entry point taking a whole buffer, e.g.
+** #define LUOS_COM_RX_BLOCK_HANDLER(DATA, SIZE) Recep_GetBlock(DATA, SIZE)
+** When the Luos core provides one, received packets are copied into the
+** message allocator in one call. Otherwise each byte goes through
+** LUOS_COM_IRQHANDLER, as with a UART.
+**
+** Luos ACK entry point, e.g.
+** #define LUOS_COM_RX_ACK_HANDLER(ACK) Recep_GetAck(ACK)
+** Received ACKs are always recognized without going through the message
+** reassembly. When the Luos core provides this hook, they also skip the
+** reception state machine; otherwise they are delivered as a one byte
+** message followed by Recep_Timeout.
+*/
+
 
 #endif /* ! LUOS_HAL_COM_CONFIG_H */
@@ -8,6 +8,7 @@
 
 // NRF
 #include "ble_nus.h"        // BLE_NUS_*, ble_nus_*
+#include "nrf_sdh_ble.h"    // NRF_SDH_BLE_OBSERVER
 #include "sdk_errors.h"     // ret_code_t
 
 #ifdef DEBUG
@@ -18,50 +19,54 @@
 #include "app_error.h"      // APP_ERROR_CHECK
 
 // SOFTDEVICE
+#include "ble.h"            /* ble_evt_t, BLE_GATTS_EVT_HVN_TX_COMPLETE,
+                            ** BLE_GAP_EVT_*
+                            */
+#include "ble_gap.h"        // ble_gap_conn_params_t
 #include "ble_types.h"      // BLE_CONN_HANDLE_INVALID
 
-// LUOS
-#include "context.h"        // ctx
-#include "reception.h"      // Recep_Timeout
-
 // CUSTOM
-#include "luos_hal_timer.h" // LuosHAL_TimeoutInit, DEFAULT_TIMEOUT
-
-#include "msg_queue.h"      // msg_queue_*, TX_BUF_SIZE
-
-/*      STATIC FUNCTIONS                                            */
-
-static inline void LuosHAL_ComReceive(void);
-
-// Sends the current buffer if needed and possible.
-static void LuosHAL_ComSendOp(void);
+#include "luos_hal_com_common.h"    /* com_rx_packet, com_tx_*,
+                                    ** com_link_timing
+                                    */
+#include "luos_hal_probe.h"         // PROBE_*
+#include "luos_hal_timer.h"         /* LuosHAL_TimeoutInit, DEFAULT_TIMEOUT,
+                                    ** LuosHAL_TimeoutSetScale
+                                    */
 
 /*      STATIC VARIABLES & CONSTANTS                                */
 
 // Number of accepted NUS clients.
 #define NB_NUS_CLIENTS  1
 
-// Current read byte.
-volatile static uint8_t s_curr_rx_byte;
+// BLE observer priority, same as the NUS service one.
+#define COM_OBS_PRIO    2
 
 // NUS client connection handle.
-static uint16_t         s_conn_handle;
+static uint16_t         s_conn_handle   = BLE_CONN_HANDLE_INVALID;
+
+/*      CALLBACKS                                                   */
+
+/* Data received:   Call com_rx_packet.
+** Comm start/stop: // FIXME Set RX state?
+*/
+static void LuosHAL_ComServerEventHandler(ble_nus_evt_t* event);
 
-// Defines if a buffer can be sent.
-static bool             s_tx_ready      = true;
+/* Notifications sent:  Send data if available. NUS TX ready events do not
+**                      tell how many notifications were sent.
+** Connection timing:   Scale the Luos timeout.
+*/
+static void LuosHAL_ComBleEventHandler(const ble_evt_t* event,
+                                       void* context);
 
 /*      INITIALIZATIONS                                             */
 
 // NUS server instance.
 BLE_NUS_DEF(s_nus, NB_NUS_CLIENTS);
 
-/*      CALLBACKS                                                   */
-
-/* Data received:   Call LuosHAL_ComReceive.
-** TX ready:        Send data if available.
-** Comm start/stop: // FIXME Set RX state?
-*/
-static void LuosHAL_ComServerEventHandler(ble_nus_evt_t* event);
+// BLE observer for notification completion.
+NRF_SDH_BLE_OBSERVER(s_com_obs, COM_OBS_PRIO,
+                     LuosHAL_ComBleEventHandler, NULL);
 
 /******************************************************************************
  * @brief Luos HAL Initialize Generale communication inter node
@@ -78,7 +83,12 @@ void LuosHAL_ComInit(uint32_t Baudrate)
     ret_code_t err_code = ble_nus_init(&s_nus, &params);
     APP_ERROR_CHECK(err_code);
 
+    com_tx_init(COM_HVN_TX_QUEUE_SIZE);
+    com_rx_init();
+
     LuosHAL_TimeoutInit();
+    // Until a connection gives the actual timing.
+    LuosHAL_TimeoutSetScale(Baudrate, 0);
 }
 /******************************************************************************
  * @brief Tx enable/disable relative to com
@@ -96,87 +106,6 @@ void LuosHAL_SetTxState(uint8_t Enable)
 void LuosHAL_SetRxState(uint8_t Enable)
 {
 }
-/******************************************************************************
- * @brief Process data transmit
- * @param None
- * @return None
- ******************************************************************************/
-uint8_t LuosHAL_ComTransmit(uint8_t *data, uint16_t size)
-{
-    if (s_conn_handle == BLE_CONN_HANDLE_INVALID)
-    {
-        #ifdef DEBUG
-        NRF_LOG_INFO("Connection handle not assigned: leaving...");
-        #endif /* DEBUG */
-
-        return 0;
-    }
-
-    #ifdef DEBUG
-    NRF_LOG_INFO("Prepare %u bytes for sending!", size);
-    NRF_LOG_HEXDUMP_INFO(data, size);
-    #endif /* DEBUG */
-
-    if (size <= TX_BUF_SIZE)
-    {
-        bool enqueued = msg_queue_enqueue(data, size);
-        if (!enqueued)
-        {
-            #ifdef DEBUG
-            NRF_LOG_INFO("Message could not be enqueued!");
-            #endif /* DEBUG */
-
-            return 0;
-        }
-    }
-    else
-    {
-        uint16_t curr_idx   = 0;
-        uint16_t cp_size    = TX_BUF_SIZE;
-        while (curr_idx < size)
-        {
-            bool enqueued = msg_queue_enqueue(data + curr_idx, cp_size);
-            if (!enqueued)
-            {
-                #ifdef DEBUG
-                NRF_LOG_INFO("Message could not be enqueued!");
-                #endif /* DEBUG */
-
-                return 0;
-            }
-
-            curr_idx += TX_BUF_SIZE;
-            if ((size - curr_idx) >= TX_BUF_SIZE)
-            {
-                cp_size = TX_BUF_SIZE;
-            }
-            else
-            {
-                cp_size = size - curr_idx;
-            }
-        }
-    }
-
-    if (s_tx_ready)
-    {
-        LuosHAL_ComSendOp();
-    }
-
-    LuosHAL_ResetTimeout(DEFAULT_TIMEOUT);
-
-    return 1;
-}
-/******************************************************************************
- * @brief Luos Tx communication complete
- * @param None
- * @return None
- ******************************************************************************/
-void LuosHAL_ComTxComplete(void)
-{
-    LuosHAL_ResetTimeout(DEFAULT_TIMEOUT);
-    s_tx_ready = true;
-    LuosHAL_ComSendOp();
-}
 /******************************************************************************
  * @brief set state of Txlock detection pin
  * @param None
@@ -219,45 +148,15 @@ void com_clock_enable(void)
 {
     // FIXME Enable COM clock.
 }
-void LUOS_COM_IRQHANDLER()
-{
-    LuosHAL_ComReceive();
-}
 
-/******************************************************************************
- * @brief Process data receive
- * @param None
- * @return None
- ******************************************************************************/
-static inline void LuosHAL_ComReceive(void)
+bool com_link_ready(void)
 {
-    ctx.rx.callback(&s_curr_rx_byte);
+    return (s_conn_handle != BLE_CONN_HANDLE_INVALID);
 }
 
-static void LuosHAL_ComSendOp(void)
+ret_code_t com_link_send(uint8_t* data, uint16_t size)
 {
-    tx_buffer_t* tx_buffer = msg_queue_peek();
-    if (tx_buffer == NULL)
-    {
-        // Queue was empty: no message to send.
-        return;
-    }
-
-    uint16_t    size    = tx_buffer->size;
-    uint8_t*    data    = tx_buffer->buffer;
-
-    #ifdef DEBUG
-    NRF_LOG_INFO("Sending %u bytes to client!", size);
-    #endif /* DEBUG */
-
-    ret_code_t err_code = ble_nus_data_send(&s_nus, data, &size,
-                                            s_conn_handle);
-    APP_ERROR_CHECK(err_code);
-
-    msg_queue_pop();
-
-    // No sending until this one is complete.
-    s_tx_ready = false;
+    return ble_nus_data_send(&s_nus, data, &size, s_conn_handle);
 }
 
 static void LuosHAL_ComServerEventHandler(ble_nus_evt_t* event)
@@ -274,26 +173,9 @@ static void LuosHAL_ComServerEventHandler(ble_nus_evt_t* event)
         NRF_LOG_HEXDUMP_INFO(rx_data.p_data, len);
         #endif /* DEBUG */
 
-        for (uint16_t rx_byte_idx = 0; rx_byte_idx < len; rx_byte_idx++)
-        {
-            s_curr_rx_byte = rx_data.p_data[rx_byte_idx];
-            LUOS_COM_IRQHANDLER();
-        }
-        if (len == 1) // Ack
-        {
-            // Manage Ack: reset recep callback and pop TX task.
-            Recep_Timeout();
-        }
-        else if (len < BLE_NUS_MAX_DATA_LEN - 1)
-        {
-            // Complete message: no need to wait for the rest.
-            Recep_Reset();
-        }
-        else
-        {
-            // Else it's partial data...
-            LuosHAL_ResetTimeout(DEFAULT_TIMEOUT);
-        }
+        PROBE_START(PROBE_COM_RX_PACKET);
+        com_rx_packet(rx_data.p_data, len);
+        PROBE_STOP(PROBE_COM_RX_PACKET);
     }
         break;
     case BLE_NUS_EVT_COMM_STARTED:
@@ -301,9 +183,33 @@ static void LuosHAL_ComServerEventHandler(ble_nus_evt_t* event)
         break;
     case BLE_NUS_EVT_COMM_STOPPED:
         s_conn_handle = BLE_CONN_HANDLE_INVALID;
+        com_tx_reset();
+        break;
+    default:
+        break;
+    }
+}
+
+static void LuosHAL_ComBleEventHandler(const ble_evt_t* event,
+                                       void* context)
+{
+    const ble_gap_conn_params_t* conn_params;
+
+    switch (event->header.evt_id)
+    {
+    case BLE_GAP_EVT_CONNECTED:
+        conn_params = &event->evt.gap_evt.params.connected.conn_params;
+        com_link_timing(conn_params->max_conn_interval,
+                        conn_params->slave_latency);
+        break;
+    case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+        conn_params = &event->evt.gap_evt.params.conn_param_update.conn_params;
+        com_link_timing(conn_params->max_conn_interval,
+                        conn_params->slave_latency);
+        break;
+    case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+        com_tx_complete(event->evt.gatts_evt.params.hvn_tx_complete.count);
         break;
-    case BLE_NUS_EVT_TX_RDY:
-        LuosHAL_ComTxComplete();
     default:
         break;
     }
@@ -10,7 +10,9 @@
 #include "msg_alloc.h"      // MsgAlloc_PullMsgFromTxTask
 
 // CUSTOM
-#include "luos_hal_timer.h" // LuosHAL_TimeoutInit, DEFAULT_TIMEOUT
+#include "luos_hal_timer.h" /* LuosHAL_TimeoutInit, DEFAULT_TIMEOUT,
+                            ** LuosHAL_TimeoutSetScale
+                            */
 
 /*      STATIC FUNCTIONS                                            */
 
@@ -31,6 +33,7 @@ void LuosHAL_ComInit(uint32_t Baudrate)
 
     // FIXME Enable COM
     LuosHAL_TimeoutInit();
+    LuosHAL_TimeoutSetScale(Baudrate, 0);
 }
 /******************************************************************************
  * @brief Tx enable/disable relative to com
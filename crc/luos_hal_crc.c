@@ -0,0 +1,220 @@
+/*      INCLUDES                                                    */
+
+#include "luos_hal.h"
+
+// C STANDARD
+#include <stdint.h>     // uint8_t, uint16_t
+
+// CUSTOM
+#include "luos_hal_probe.h" // PROBE_*
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
+/* Tables are generated by the preprocessor from CRC_POLYNOMIAL, using
+** the linearity of the CRC: the CRC of a byte is the XOR of the CRCs of
+** each of its set bits, so only 8 values per table (the basis) are
+** computed bit by bit, and every entry is a combination of them.
+*/
+
+// One step of the bitwise algorithm on a 16 bits value.
+#define CRC_STEP(c)     ((((c) << 1) & 0xFFFF) \
+                        ^ (((c) & 0x8000) ? CRC_POLYNOMIAL : 0))
+#define CRC_STEP4(c)    CRC_STEP(CRC_STEP(CRC_STEP(CRC_STEP(c))))
+#define CRC_STEP8(c)    CRC_STEP4(CRC_STEP4(c))
+
+#if (CRC_PROFILE == CRC_PROFILE_NIBBLE)
+
+// Basis: CRC of each bit of a nibble.
+enum
+{
+    CRC_N_0 = CRC_STEP4(0x1000),
+    CRC_N_1 = CRC_STEP4(0x2000),
+    CRC_N_2 = CRC_STEP4(0x4000),
+    CRC_N_3 = CRC_STEP4(0x8000),
+};
+
+#define CRC_NIBBLE_ENTRY(x) ((((x) & 0x1) ? CRC_N_0 : 0)    \
+                            ^ (((x) & 0x2) ? CRC_N_1 : 0)   \
+                            ^ (((x) & 0x4) ? CRC_N_2 : 0)   \
+                            ^ (((x) & 0x8) ? CRC_N_3 : 0))
+#define CRC_NIBBLE_X4(x)    CRC_NIBBLE_ENTRY(x),        \
+                            CRC_NIBBLE_ENTRY((x) + 1),  \
+                            CRC_NIBBLE_ENTRY((x) + 2),  \
+                            CRC_NIBBLE_ENTRY((x) + 3)
+
+// CRC of each nibble value.
+static const uint16_t s_crc_nibble_table[16] =
+{
+    CRC_NIBBLE_X4(0), CRC_NIBBLE_X4(4), CRC_NIBBLE_X4(8), CRC_NIBBLE_X4(12),
+};
+
+#elif (CRC_PROFILE == CRC_PROFILE_TABLE) || (CRC_PROFILE == CRC_PROFILE_SLICE)
+
+// Combines the basis of row n according to the bits of byte x.
+#define CRC_ENTRY(n, x) ((((x) & 0x01) ? CRC_B##n##_0 : 0)     \
+                        ^ (((x) & 0x02) ? CRC_B##n##_1 : 0)    \
+                        ^ (((x) & 0x04) ? CRC_B##n##_2 : 0)    \
+                        ^ (((x) & 0x08) ? CRC_B##n##_3 : 0)    \
+                        ^ (((x) & 0x10) ? CRC_B##n##_4 : 0)    \
+                        ^ (((x) & 0x20) ? CRC_B##n##_5 : 0)    \
+                        ^ (((x) & 0x40) ? CRC_B##n##_6 : 0)    \
+                        ^ (((x) & 0x80) ? CRC_B##n##_7 : 0))
+
+// Pushes a null byte through a basis value (uses the byte basis).
+#define CRC_SHIFT8(c)   ((((c) << 8) & 0xFFFF) ^ CRC_ENTRY(0, (c) >> 8))
+
+/* Basis: CRC_B<n>_<i> is the CRC of bit i of a byte, followed by n null
+** bytes.
+*/
+#define CRC_BASIS_ROW(n, p) CRC_B##n##_0 = CRC_SHIFT8(CRC_B##p##_0),   \
+                            CRC_B##n##_1 = CRC_SHIFT8(CRC_B##p##_1),   \
+                            CRC_B##n##_2 = CRC_SHIFT8(CRC_B##p##_2),   \
+                            CRC_B##n##_3 = CRC_SHIFT8(CRC_B##p##_3),   \
+                            CRC_B##n##_4 = CRC_SHIFT8(CRC_B##p##_4),   \
+                            CRC_B##n##_5 = CRC_SHIFT8(CRC_B##p##_5),   \
+                            CRC_B##n##_6 = CRC_SHIFT8(CRC_B##p##_6),   \
+                            CRC_B##n##_7 = CRC_SHIFT8(CRC_B##p##_7)
+enum
+{
+    CRC_B0_0 = CRC_STEP8(0x0100),
+    CRC_B0_1 = CRC_STEP8(0x0200),
+    CRC_B0_2 = CRC_STEP8(0x0400),
+    CRC_B0_3 = CRC_STEP8(0x0800),
+    CRC_B0_4 = CRC_STEP8(0x1000),
+    CRC_B0_5 = CRC_STEP8(0x2000),
+    CRC_B0_6 = CRC_STEP8(0x4000),
+    CRC_B0_7 = CRC_STEP8(0x8000),
+#if (CRC_PROFILE == CRC_PROFILE_SLICE)
+    CRC_BASIS_ROW(1, 0),
+    CRC_BASIS_ROW(2, 1),
+    CRC_BASIS_ROW(3, 2),
+    CRC_BASIS_ROW(4, 3),
+    CRC_BASIS_ROW(5, 4),
+    CRC_BASIS_ROW(6, 5),
+    CRC_BASIS_ROW(7, 6),
+#endif
+};
+
+#define CRC_X4(n, x)    CRC_ENTRY(n, x), CRC_ENTRY(n, (x) + 1),    \
+                        CRC_ENTRY(n, (x) + 2), CRC_ENTRY(n, (x) + 3)
+#define CRC_X16(n, x)   CRC_X4(n, x), CRC_X4(n, (x) + 4),          \
+                        CRC_X4(n, (x) + 8), CRC_X4(n, (x) + 12)
+#define CRC_X64(n, x)   CRC_X16(n, x), CRC_X16(n, (x) + 16),       \
+                        CRC_X16(n, (x) + 32), CRC_X16(n, (x) + 48)
+#define CRC_ROW(n)      { CRC_X64(n, 0), CRC_X64(n, 64),           \
+                          CRC_X64(n, 128), CRC_X64(n, 192) }
+
+#if (CRC_PROFILE == CRC_PROFILE_SLICE)
+#define CRC_TABLE_NB    CRC_SLICE_NB
+#else
+#define CRC_TABLE_NB    1
+#endif
+
+/* s_crc_table[0][b] is the CRC of byte b, and s_crc_table[n][b] the CRC
+** of byte b followed by n null bytes.
+*/
+static const uint16_t s_crc_table[CRC_TABLE_NB][256] =
+{
+    CRC_ROW(0),
+#if (CRC_TABLE_NB > 1)
+    CRC_ROW(1),
+#endif
+#if (CRC_TABLE_NB > 2)
+    CRC_ROW(2),
+#endif
+#if (CRC_TABLE_NB > 3)
+    CRC_ROW(3),
+#endif
+#if (CRC_TABLE_NB > 4)
+    CRC_ROW(4),
+#endif
+#if (CRC_TABLE_NB > 5)
+    CRC_ROW(5),
+#endif
+#if (CRC_TABLE_NB > 6)
+    CRC_ROW(6),
+#endif
+#if (CRC_TABLE_NB > 7)
+    CRC_ROW(7),
+#endif
+};
+
+#endif /* CRC_PROFILE */
+
+/*      STATIC FUNCTIONS                                            */
+
+// Adds one byte to the given CRC with the configured profile.
+static inline uint16_t LuosHAL_CRCUpdate(uint16_t crc, uint8_t data);
+
+/******************************************************************************
+ * @brief Compute CRC
+ * @param data : Byte to add to the CRC
+ * @param crc : Running CRC, updated in place
+ * @return None
+ ******************************************************************************/
+void LuosHAL_ComputeCRC(uint8_t *data, uint8_t *crc)
+{
+    // Not probed: recording a measure costs more than a byte of CRC.
+    *(uint16_t *)crc = LuosHAL_CRCUpdate(*(uint16_t *)crc, data[0]);
+}
+/******************************************************************************
+ * @brief Compute CRC on a whole buffer, same result as calling
+ *        LuosHAL_ComputeCRC on each byte
+ * @param data : Buffer to add to the CRC
+ * @param size : Size of the buffer
+ * @param crc : Running CRC, updated in place
+ * @return None
+ ******************************************************************************/
+void LuosHAL_ComputeCRCBlock(uint8_t *data, uint16_t size, uint8_t *crc)
+{
+    PROBE_START(PROBE_CRC_BLOCK);
+    uint16_t curr_crc = *(uint16_t *)crc;
+
+#if (CRC_PROFILE == CRC_PROFILE_SLICE)
+    // The CRC bytes are merged into the first two data bytes of a slice.
+    while (size >= CRC_SLICE_NB)
+    {
+        uint16_t slice_crc = s_crc_table[CRC_SLICE_NB - 1][(curr_crc >> 8) ^ data[0]]
+                             ^ s_crc_table[CRC_SLICE_NB - 2][(curr_crc & 0xFF) ^ data[1]];
+        for (uint8_t i = 2; i < CRC_SLICE_NB; i++)
+        {
+            slice_crc ^= s_crc_table[CRC_SLICE_NB - 1 - i][data[i]];
+        }
+        curr_crc = slice_crc;
+
+        data += CRC_SLICE_NB;
+        size -= CRC_SLICE_NB;
+    }
+#endif /* CRC_PROFILE_SLICE */
+
+    while (size > 0)
+    {
+        curr_crc = LuosHAL_CRCUpdate(curr_crc, *data);
+        data++;
+        size--;
+    }
+
+    *(uint16_t *)crc = curr_crc;
+    PROBE_STOP(PROBE_CRC_BLOCK);
+}
+
+static inline uint16_t LuosHAL_CRCUpdate(uint16_t crc, uint8_t data)
+{
+#if (CRC_PROFILE == CRC_PROFILE_BITWISE)
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t j = 0; j < 8; ++j)
+    {
+        uint16_t mix = crc & 0x8000;
+        crc = (crc << 1);
+        if (mix)
+            crc = crc ^ CRC_POLYNOMIAL;
+    }
+    return crc;
+#elif (CRC_PROFILE == CRC_PROFILE_NIBBLE)
+    crc = (crc << 4) ^ s_crc_nibble_table[(crc >> 12) ^ (data >> 4)];
+    crc = (crc << 4) ^ s_crc_nibble_table[(crc >> 12) ^ (data & 0x0F)];
+    return crc;
+#else
+    return (crc << 8) ^ s_crc_table[0][(crc >> 8) ^ data];
+#endif
+}
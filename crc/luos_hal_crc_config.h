@@ -0,0 +1,42 @@
+#ifndef LUOS_HAL_CRC_CONFIG_H
+#define LUOS_HAL_CRC_CONFIG_H
+
+/*******************************************************************************
+ * CRC CONFIG
+ ******************************************************************************/
+/* The NRF52832 has no general purpose CRC peripheral: every profile is a
+** software one, all giving the same result. From smallest to fastest:
+*/
+// Bitwise loop, no table.
+#define CRC_PROFILE_BITWISE     0
+// One nibble at a time, 16 entries table (32 bytes of flash).
+#define CRC_PROFILE_NIBBLE      1
+// One byte at a time, 256 entries table (512 bytes of flash).
+#define CRC_PROFILE_TABLE       2
+// CRC_SLICE_NB bytes at a time on blocks, CRC_SLICE_NB * 512 bytes of flash.
+#define CRC_PROFILE_SLICE       3
+
+#ifndef CRC_PROFILE
+#define CRC_PROFILE             CRC_PROFILE_SLICE
+#endif
+
+// Bytes processed per iteration by the slice profile, from 2 to 8.
+#ifndef CRC_SLICE_NB
+#define CRC_SLICE_NB            4
+#endif
+
+// CRC-16 polynomial, MSB first.
+#ifndef CRC_POLYNOMIAL
+#define CRC_POLYNOMIAL          0x0007
+#endif
+
+#ifdef CRC_HW
+#error "No CRC peripheral on this MCU family: select a CRC_PROFILE instead."
+#endif
+
+#if (CRC_PROFILE == CRC_PROFILE_SLICE) \
+    && ((CRC_SLICE_NB < 2) || (CRC_SLICE_NB > 8))
+#error "CRC_SLICE_NB must be between 2 and 8."
+#endif
+
+#endif /* ! LUOS_HAL_CRC_CONFIG_H */
@@ -15,6 +15,9 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "nrf.h"        // DWT, CoreDebug, for IRQ_MASK_STATS and HAL_PROBES
+#include "nrf_nvic.h"   // sd_nvic_critical_region_*
+
 #include "reception.h"
 #include "context.h"
 #include "msg_alloc.h"
@@ -23,11 +26,22 @@
 /*******************************************************************************
  * Variables
  ******************************************************************************/
+// Number of LuosHAL_SetIrqState(false) calls not yet balanced.
+static uint8_t s_irq_nesting = 0;
+
+// Whether the outermost critical section was nested in a SoftDevice one.
+static uint8_t s_irq_nested_region = 0;
+
+static irq_stats_t s_irq_stats;
+
+#if (IRQ_MASK_STATS != DISABLE)
+// Cycle count when the outermost critical section was entered.
+static uint32_t s_irq_masked_start;
+#endif
 
 /*******************************************************************************
  * Function
  ******************************************************************************/
-static void LuosHAL_CRCInit(void);
 
 /////////////////////////Luos Library Needed function///////////////////////////
 
@@ -38,6 +52,13 @@ static void LuosHAL_CRCInit(void);
  ******************************************************************************/
 void LuosHAL_Init(void)
 {
+#if (IRQ_MASK_STATS != DISABLE) || (HAL_PROBES != DISABLE)
+    // Start the cycle counter used to time critical sections and probes
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
     // Board Initialization
     LuosHAL_BoardInit();
 
@@ -57,58 +78,61 @@ void LuosHAL_Init(void)
     LuosHAL_BleSetup();
     LuosHAL_BleConnect();
 
-    // CRC Initialization
-    LuosHAL_CRCInit();
-
     //Com Initialization
     LuosHAL_ComInit(DEFAULTBAUDRATE);
 }
 /******************************************************************************
- * @brief Luos HAL general disable IRQ
- * @param None
+ * @brief Luos HAL general disable IRQ, calls can be nested: interrupts are
+ *        enabled back by the call balancing the first disable
+ * @param Enable : false to enter a critical section, true to leave it
  * @return None
  ******************************************************************************/
 void LuosHAL_SetIrqState(uint8_t Enable)
 {
     if (Enable == true)
     {
-        // FIXME ENABLE IRQ
+        if (s_irq_nesting == 0)
+        {
+            // Not in a critical section
+            return;
+        }
+        s_irq_nesting--;
+        if (s_irq_nesting == 0)
+        {
+#if (IRQ_MASK_STATS != DISABLE)
+            uint32_t masked = DWT->CYCCNT - s_irq_masked_start;
+            s_irq_stats.masked_nb++;
+            s_irq_stats.masked_sum += masked;
+            if (masked > s_irq_stats.masked_max)
+            {
+                s_irq_stats.masked_max = masked;
+            }
+#endif
+            // SoftDevice safe: only masks application interrupts
+            sd_nvic_critical_region_exit(s_irq_nested_region);
+        }
     }
     else
     {
-        // FIXME DISABLE IRQ
+        uint8_t nested_region;
+        sd_nvic_critical_region_enter(&nested_region);
+        if (s_irq_nesting == 0)
+        {
+            s_irq_nested_region = nested_region;
+#if (IRQ_MASK_STATS != DISABLE)
+            s_irq_masked_start = DWT->CYCCNT;
+#endif
+        }
+        s_irq_nesting++;
     }
 }
 /******************************************************************************
- * @brief Initialize CRC Process
- * @param None
- * @return None
- ******************************************************************************/
-static void LuosHAL_CRCInit(void)
-{
-    //CRC initialisation
-}
-/******************************************************************************
- * @brief Compute CRC
+ * @brief Time spent with interrupts masked by LuosHAL_SetIrqState, only
+ *        measured with IRQ_MASK_STATS
  * @param None
- * @return None
+ * @return Statistics since startup
  ******************************************************************************/
-void LuosHAL_ComputeCRC(uint8_t *data, uint8_t *crc)
+const irq_stats_t *LuosHAL_GetIrqStats(void)
 {
-#ifdef CRC_HW
-    //CRC HW calculation
-#else
-    for (uint8_t i = 0; i < 1; ++i)
-    {
-        uint16_t dbyte = data[i];
-        *(uint16_t *)crc ^= dbyte << 8;
-        for (uint8_t j = 0; j < 8; ++j)
-        {
-            uint16_t mix = *(uint16_t *)crc & 0x8000;
-            *(uint16_t *)crc = (*(uint16_t *)crc << 1);
-            if (mix)
-                *(uint16_t *)crc = *(uint16_t *)crc ^ 0x0007;
-        }
-    }
-#endif
+    return &s_irq_stats;
 }
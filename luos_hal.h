@@ -19,13 +19,23 @@
 
 #define ADDRESS_ALIASES_FLASH ADDRESS_LAST_PAGE_FLASH
 #define ADDRESS_BOOT_FLAG_FLASH (ADDRESS_LAST_PAGE_FLASH + PAGE_SIZE) - 4
+
+// Time spent with interrupts masked, in CPU cycles (SystemCoreClock).
+typedef struct
+{
+    uint32_t masked_nb;     // Outermost critical sections left
+    uint32_t masked_max;    // Longest one
+    uint64_t masked_sum;    // All of them
+} irq_stats_t;
 /*******************************************************************************
  * Function
  ******************************************************************************/
 void LuosHAL_Init(void);
 void LuosHAL_SetIrqState(uint8_t Enable);
+const irq_stats_t *LuosHAL_GetIrqStats(void);
 uint8_t LuosHAL_GetPTPState(uint8_t PTPNbr);
 void LuosHAL_ComputeCRC(uint8_t *data, uint8_t *crc);
+void LuosHAL_ComputeCRCBlock(uint8_t *data, uint16_t size, uint8_t *crc);
 
 // luos_hal_com_*.c
 void LuosHAL_ComInit(uint32_t Baudrate);
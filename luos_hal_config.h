@@ -13,6 +13,7 @@
 //include file relative to your MCU family
 
 #define DISABLE 0x00
+#define ENABLE  0x01
 /*******************************************************************************
  * PINOUT CONFIG
  ******************************************************************************/
@@ -22,14 +23,18 @@
                             } while(0U)
 #endif
 
-// Max amount of milliseconds the systick can wait.
-#ifndef MAX_SYSTICK_MS_VAL
-#define MAX_SYSTICK_MS_VAL 250
+/* Measure the time spent with interrupts masked by LuosHAL_SetIrqState,
+** see LuosHAL_GetIrqStats. Uses the DWT cycle counter.
+*/
+#ifndef IRQ_MASK_STATS
+#define IRQ_MASK_STATS DISABLE
 #endif
 
 #include "luos_hal_flash_config.h"
 #include "luos_hal_timer_config.h"
 #include "luos_hal_ptp_config.h"
 #include "luos_hal_com_config.h"
+#include "luos_hal_crc_config.h"
+#include "luos_hal_probe_config.h"
 
 #endif /* _LUOSHAL_CONFIG_H_ */
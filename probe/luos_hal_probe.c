@@ -0,0 +1,97 @@
+#include "luos_hal_probe.h"
+
+/*      INCLUDES                                                    */
+
+// C STANDARD
+#include <stdbool.h>        // true, false
+#include <stddef.h>         // NULL
+#include <stdint.h>         // uint8_t, uint32_t
+#include <string.h>         // memset
+
+#if (HAL_PROBES != DISABLE)
+
+#ifdef DEBUG
+#include "nrf_log.h"        // NRF_LOG_*
+#endif /* DEBUG */
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
+// Probe counters, min only makes sense once count is not 0.
+static probe_stats_t s_probes[PROBE_NB];
+
+#ifdef DEBUG
+// Probe names, as dumped.
+static const char* const s_probe_names[PROBE_NB] =
+{
+    [PROBE_COM_TRANSMIT]    = "com_transmit",
+    [PROBE_COM_SEND]        = "com_send",
+    [PROBE_COM_RX_PACKET]   = "com_rx_packet",
+    [PROBE_COM_RX_PROCESS]  = "com_rx_process",
+    [PROBE_CRC_BLOCK]       = "crc_block",
+};
+#endif /* DEBUG */
+
+void probe_record(probe_id_t id, uint32_t cycles)
+{
+    // Probes also run in interrupts.
+    LuosHAL_SetIrqState(false);
+
+    probe_stats_t* probe = &s_probes[id];
+    if ((probe->count == 0) || (cycles < probe->min))
+    {
+        probe->min = cycles;
+    }
+    if (cycles > probe->max)
+    {
+        probe->max = cycles;
+    }
+    probe->sum += cycles;
+    probe->count++;
+
+    LuosHAL_SetIrqState(true);
+}
+
+const probe_stats_t* LuosHAL_ProbeGet(probe_id_t id)
+{
+    return &s_probes[id];
+}
+
+void LuosHAL_ProbeReset(void)
+{
+    LuosHAL_SetIrqState(false);
+    memset(s_probes, 0, sizeof(s_probes));
+    LuosHAL_SetIrqState(true);
+}
+
+void LuosHAL_ProbeDump(void)
+{
+    #ifdef DEBUG
+    for (uint8_t id = 0; id < PROBE_NB; id++)
+    {
+        probe_stats_t probe = *LuosHAL_ProbeGet(id);
+        uint32_t mean = (probe.count != 0) ?
+                        (uint32_t)(probe.sum / probe.count) : 0;
+        NRF_LOG_INFO("PROBE %s %u %u %u %u", s_probe_names[id],
+                     probe.count, probe.min, probe.max, mean);
+    }
+    #endif /* DEBUG */
+}
+
+#else
+
+// Probes disabled: nothing is measured.
+
+const probe_stats_t* LuosHAL_ProbeGet(probe_id_t id)
+{
+    return NULL;
+}
+
+void LuosHAL_ProbeReset(void)
+{
+}
+
+void LuosHAL_ProbeDump(void)
+{
+}
+
+#endif /* HAL_PROBES */
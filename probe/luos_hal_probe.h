@@ -0,0 +1,71 @@
+#ifndef LUOS_HAL_PROBE_H
+#define LUOS_HAL_PROBE_H
+
+/*      INCLUDES                                                    */
+
+#include "luos_hal.h"
+
+// C STANDARD
+#include <stdint.h>         // uint32_t, uint64_t
+
+#if (HAL_PROBES != DISABLE)
+#include "nrf.h"            // DWT
+#endif /* HAL_PROBES */
+
+/*      TYPES                                                       */
+
+// Probed hot paths.
+typedef enum
+{
+    PROBE_COM_TRANSMIT,     // Queuing a message for sending
+    PROBE_COM_SEND,         // Building and handing packets to the BLE stack
+    PROBE_COM_RX_PACKET,    // BLE reception handler
+    PROBE_COM_RX_PROCESS,   // Handing a received packet to Luos
+    PROBE_CRC_BLOCK,        // LuosHAL_ComputeCRCBlock
+    PROBE_NB
+} probe_id_t;
+
+// CPU cycles spent between the start and stop of a probe.
+typedef struct
+{
+    uint32_t    count;
+    uint32_t    min;
+    uint32_t    max;
+    uint64_t    sum;
+} probe_stats_t;
+
+/*      MACROS                                                      */
+
+/* Measures the code between both, in the same block:
+**      PROBE_START(PROBE_CRC_BLOCK);
+**      ...
+**      PROBE_STOP(PROBE_CRC_BLOCK);
+*/
+#if (HAL_PROBES != DISABLE)
+#define PROBE_START(ID)     const uint32_t probe_start_##ID = DWT->CYCCNT
+#define PROBE_STOP(ID)      probe_record((ID), DWT->CYCCNT - probe_start_##ID)
+#else
+#define PROBE_START(ID)
+#define PROBE_STOP(ID)
+#endif /* HAL_PROBES */
+
+/*      FUNCTIONS                                                   */
+
+#if (HAL_PROBES != DISABLE)
+// Adds a measure to the given probe, from any context.
+void probe_record(probe_id_t id, uint32_t cycles);
+#endif /* HAL_PROBES */
+
+// Returns the counters of the given probe, NULL when probes are disabled.
+const probe_stats_t* LuosHAL_ProbeGet(probe_id_t id);
+
+// Clears the counters of every probe.
+void LuosHAL_ProbeReset(void);
+
+/* Logs one line per probe, decoded by tools/probe_decode.py:
+**      PROBE <name> <count> <min> <max> <mean>
+** with cycles at SystemCoreClock. Only available in DEBUG builds.
+*/
+void LuosHAL_ProbeDump(void);
+
+#endif /* ! LUOS_HAL_PROBE_H */
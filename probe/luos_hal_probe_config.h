@@ -0,0 +1,16 @@
+#ifndef LUOS_HAL_PROBE_CONFIG_H
+#define LUOS_HAL_PROBE_CONFIG_H
+
+#include "luos_hal_config.h"    // DISABLE
+
+/*******************************************************************************
+ * PROBES CONFIG
+ ******************************************************************************/
+/* Counts the CPU cycles spent in the HAL hot paths with the DWT cycle
+** counter, see luos_hal_probe.h. Probes compile to nothing when disabled.
+*/
+#ifndef HAL_PROBES
+#define HAL_PROBES              DISABLE
+#endif
+
+#endif /* ! LUOS_HAL_PROBE_CONFIG_H */
@@ -1,12 +1,36 @@
 #include "luos_hal_systick.h"
+#include "luos_hal.h"
 
-#include <stdio.h>
+/*      INCLUDES                                                    */
+
+// C STANDARD
+#include <stdbool.h>        // true, false
+#include <stdint.h>         // uint32_t, uint64_t
+
+// NRF
+#include "sdk_errors.h"     // ret_code_t
 
 // NRFX DRIVERS
 #include "nrfx_systick.h"   /* nrfx_systick_init, nrfx_systick_state_t,
                             ** nrfx_systick_get
                             */
 
+// NRF APPS
+#include "app_error.h"      // APP_ERROR_CHECK
+#include "app_timer.h"      // APP_TIMER_*, app_timer_*
+
+/*      STATIC FUNCTIONS                                            */
+
+// RTC ticks to microseconds.
+static inline uint64_t systick_rtc_to_us(uint64_t ticks);
+
+/*      CALLBACKS                                                   */
+
+// Keeps the RTC extension up to date while nobody reads the time.
+static void systick_refresh_handler(void* context);
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
 // Amount of bytes in the systick register
 #define SYSTICK_NB_BITS 24
 
@@ -16,11 +40,41 @@ static const uint32_t SYSTICK_MAX_VAL = (1 << SYSTICK_NB_BITS) - 1;
 // Systick frequency: 64MHz.
 #define TICKS_IN_SECOND ((uint32_t)64000000UL)
 
-// Milliseconds in a second.
-#define MS_IN_SECOND    ((uint32_t)1000UL)
+// Microseconds in a second.
+#define US_IN_SECOND    ((uint32_t)1000000UL)
 
-// Number of ticks in a millisecond.
-static const uint32_t TICKS_IN_MS = TICKS_IN_SECOND / MS_IN_SECOND;
+// Number of ticks in a microsecond.
+static const uint32_t TICKS_IN_US = TICKS_IN_SECOND / US_IN_SECOND;
+
+// Microseconds in a millisecond.
+#define US_IN_MS        ((uint32_t)1000UL)
+
+/* The 24 bits RTC counter wraps after 512 s at 32768 Hz: it is read at
+** least this often to count its wraps.
+*/
+#define REFRESH_PERIOD_MS   60000
+
+/* The systick wraps every 262 ms: it only refines the time when the
+** previous reading is recent enough, in RTC ticks.
+*/
+#define SYSTICK_SPAN_RTC    ((uint32_t)(((uint64_t)SYSTICK_MAX_VAL      \
+                             * APP_TIMER_CLOCK_FREQ)                    \
+                             / ((uint64_t)TICKS_IN_SECOND               \
+                             * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))    \
+                             / 2))
+
+// RTC ticks since startup, wraps included, and last counter value read.
+static uint64_t s_rtc_ticks     = 0;
+static uint32_t s_rtc_last      = 0;
+
+// Last time returned, and systick value when it was computed.
+static uint64_t s_time_us       = 0;
+static uint32_t s_systick_last  = 0;
+
+/*      INITIALIZATIONS                                             */
+
+// RTC extension refresh timer.
+APP_TIMER_DEF(s_refresh_timer);
 
 /******************************************************************************
  * @brief Luos HAL general systick tick at 1ms initialize
@@ -30,20 +84,76 @@ static const uint32_t TICKS_IN_MS = TICKS_IN_SECOND / MS_IN_SECOND;
 void LuosHAL_SystickInit(void)
 {
     nrfx_systick_init();
+
+    s_rtc_last = app_timer_cnt_get();
+
+    ret_code_t err_code = app_timer_create(&s_refresh_timer,
+                                           APP_TIMER_MODE_REPEATED,
+                                           systick_refresh_handler);
+    APP_ERROR_CHECK(err_code);
+    err_code = app_timer_start(s_refresh_timer,
+                               APP_TIMER_TICKS(REFRESH_PERIOD_MS), NULL);
+    APP_ERROR_CHECK(err_code);
 }
 
 /******************************************************************************
  * @brief Luos HAL general systick tick at 1ms
  * @param None
- * @return tick Counter
+ * @return tick Counter, wraps after 49 days
  ******************************************************************************/
 uint32_t LuosHAL_GetSystick(void)
 {
+    return (uint32_t)(LuosHAL_GetTimeUs() / US_IN_MS);
+}
+
+uint64_t LuosHAL_GetTimeUs(void)
+{
+    LuosHAL_SetIrqState(false);
+
+    uint32_t rtc = app_timer_cnt_get();
     nrfx_systick_state_t systick_state;
     nrfx_systick_get(&systick_state);
 
-    uint32_t systick_time = systick_state.time;
-    uint32_t inc_val = SYSTICK_MAX_VAL - systick_time;
+    uint32_t rtc_elapsed = app_timer_cnt_diff_compute(rtc, s_rtc_last);
+    s_rtc_ticks += rtc_elapsed;
+    s_rtc_last   = rtc;
+
+    // Start of the current RTC tick, the systick refines it.
+    uint64_t rtc_us     = systick_rtc_to_us(s_rtc_ticks);
+    uint64_t rtc_next   = systick_rtc_to_us(s_rtc_ticks + 1);
+    uint64_t time_us    = rtc_us;
+    if (rtc_elapsed < SYSTICK_SPAN_RTC)
+    {
+        // Down counter.
+        uint32_t systick_elapsed = (s_systick_last - systick_state.time)
+                                   & SYSTICK_MAX_VAL;
+        uint64_t fine_us = s_time_us + systick_elapsed / TICKS_IN_US;
+        if ((fine_us > rtc_us) && (fine_us < rtc_next))
+        {
+            time_us = fine_us;
+        }
+    }
+
+    // Never goes back, whatever the drift between both clocks.
+    if (time_us < s_time_us)
+    {
+        time_us = s_time_us;
+    }
+    s_time_us       = time_us;
+    s_systick_last  = systick_state.time;
 
-    return inc_val / TICKS_IN_MS;
+    LuosHAL_SetIrqState(true);
+
+    return time_us;
+}
+
+static inline uint64_t systick_rtc_to_us(uint64_t ticks)
+{
+    return (ticks * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1) * US_IN_SECOND)
+           / APP_TIMER_CLOCK_FREQ;
+}
+
+static void systick_refresh_handler(void* context)
+{
+    (void)LuosHAL_GetTimeUs();
 }
@@ -1,6 +1,14 @@
 #ifndef LUOS_HAL_SYSTICK_H
 #define LUOS_HAL_SYSTICK_H
 
+#include <stdint.h> // uint64_t
+
 void LuosHAL_SystickInit(void);
 
+/* Microseconds since startup, never wrapping: RTC based, refined by the
+** systick between RTC ticks. LuosHAL_GetSystick returns the same time in
+** milliseconds.
+*/
+uint64_t LuosHAL_GetTimeUs(void);
+
 #endif /* ! LUOS_HAL_SYSTICK_H */
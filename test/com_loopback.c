@@ -0,0 +1,609 @@
+/* Host loopback test of the BLE COM layer (com/common/luos_hal_com_common.c):
+** random messages go through LuosHAL_ComTransmit and LuosHAL_ComTransmitV,
+** are framed in records and packed in packets by the TX pump, handed to
+** a simulated BLE link which randomly refuses packets (backpressure), then
+** fed back to com_rx_packet. Luos is stubbed on the receiving side: it
+** records the bytes and message ends it gets.
+**
+** The test checks that every accepted message comes out once, whole and in
+** order within its lane (short control messages overtake bulk ones), that
+** no packet is larger than the ATT payload, that nothing is dropped, in
+** zero copy mode that each message buffer is released once and, with the
+** fused CRC, that the CRC of each received message, its last two bytes
+** excluded, matches LuosHAL_ComputeCRC. It then checks that a reassembled
+** message is dropped past its deadline only.
+**
+** Build and run from the repository root, with the default configuration:
+**   gcc -std=gnu99 -O2 -Wall -Wextra -fsanitize=address,undefined     \
+**       -Itest/stub -I. -Icom -Icom/common -Iflash -Itimer -Iptp       \
+**       -Icrc -Iprobe -Ible/common test/com_loopback.c                 \
+**       test/stub/app_timer.c com/common/luos_hal_com_common.c         \
+**       com/common/luos_hal_com_queue.c crc/luos_hal_crc.c             \
+**       -o com_loopback
+**   ./com_loopback
+** and again with any of these options:
+**   '-DLUOS_COM_RX_BLOCK_HANDLER(D,S)=test_rx_block(D,S)'
+**   -DCOM_TX_ZERO_COPY=1 '-DLUOS_COM_TX_RELEASE(D)=test_tx_release(D)'
+**   -DCOM_TX_COALESCING=0         -DCOM_TX_FLUSH_DEADLINE=5
+**   -DCOM_TX_FLUSH_DEADLINE=500
+**   -DCOM_TX_ACK_PIGGYBACK=1      -DCOM_RX_MSG_SIZE_MAX=0
+**   -DCOM_RX_DEFERRED=1           -DCOM_RX_DEFERRED=2
+**   -DCOM_RX_FUSED_CRC=1
+**   -DLINK_SLOW                   the default ATT payload on 50 ms events
+** adding -DLUOS_COM_HOOKS_HEADER='"com_hooks.h"' to the hook options.
+*/
+
+/*      INCLUDES                                                    */
+
+#include "luos_hal.h"
+
+// C STANDARD
+#include <stdbool.h>        // bool
+#include <stdint.h>         // uint8_t, uint16_t, uint32_t
+#include <stdio.h>          // printf
+#include <stdlib.h>         // rand, srand, exit, EXIT_*
+#include <string.h>         // memcpy, memcmp
+
+// STUBS
+#include "app_scheduler.h"  // g_sched_pending
+#include "app_timer.h"      // app_timer_stub_advance
+#include "context.h"        // ctx
+#include "nrf_nvic.h"       // g_nvic_pending_irq
+#include "sdk_errors.h"     // ret_code_t, NRF_*
+
+// CUSTOM
+#include "luos_hal_ble_common.h"    // att_payload_cb_t
+#include "luos_hal_com.h"           /* LuosHAL_ComTransmitV,
+                                    ** LuosHAL_ComGetRxCRC, com_stats_t
+                                    */
+#include "luos_hal_com_common.h"    // com_*
+
+#if (COM_RX_DEFERRED == COM_RX_DEFER_SWI)
+void COM_RX_SWI_IRQHANDLER(void);
+#endif /* COM_RX_DEFERRED */
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
+// Rounds of random traffic.
+#define ROUND_NB            20000
+
+/* Simulated link: ATT payload, connection interval (1.25 ms units) and
+** peripheral latency, app_timer ticks per round, and one round in
+** TX_ROUND_RATIO sends a message. LINK_SLOW gives one connection event
+** per round, with the ATT payload before any MTU exchange, and a load
+** the link can carry: an overloaded control lane starves bulk messages
+** whatever their deadline.
+*/
+#ifdef LINK_SLOW
+#define LINK_PAYLOAD        20
+#define LINK_INTERVAL       40
+#define LINK_LATENCY        0
+#define ROUND_TICKS         APP_TIMER_TICKS(50)
+#define TX_ROUND_RATIO      8
+#else
+#define LINK_PAYLOAD        244
+#define LINK_INTERVAL       24
+#define LINK_LATENCY        1
+#define ROUND_TICKS         33
+#define TX_ROUND_RATIO      2
+#endif /* LINK_SLOW */
+
+// Rounds given to the queues to drain at the end.
+#define DRAIN_ROUND_NB      10000
+
+// Largest message sent, within the reassembly buffer if any.
+#if (COM_RX_MSG_SIZE_MAX != 0) && (COM_RX_MSG_SIZE_MAX < 600)
+#define MSG_SIZE_MAX        COM_RX_MSG_SIZE_MAX
+#else
+#define MSG_SIZE_MAX        600
+#endif
+
+// Bytes and messages logged on each side.
+#define LOG_SIZE            (1024 * 1024)
+#define LOG_MSG_NB          20000
+
+// Packets the BLE stack of the simulated link holds.
+#define LINK_QUEUE_SIZE     4
+
+/* Packets received before the deferred reception runs: a drained RX queue
+** only surely fits half its arena.
+*/
+#if (COM_RX_DEFERRED != DISABLE)
+#define RX_BURST_MAX        (COM_RX_ARENA_SIZE / 2 / LINK_PAYLOAD)
+#else
+#define RX_BURST_MAX        LINK_QUEUE_SIZE
+#endif /* COM_RX_DEFERRED */
+
+// Messages sent or received, back to back, with their start and size.
+typedef struct
+{
+    uint8_t     bytes[LOG_SIZE];
+    uint32_t    size;
+    uint32_t    msg_start[LOG_MSG_NB];
+    uint32_t    msg_size[LOG_MSG_NB];
+    uint32_t    msg_nb;
+} msg_log_t;
+
+// Sent messages stay in the log: zero copy buffers are never reused.
+static msg_log_t    s_tx_log;
+static msg_log_t    s_rx_log;
+
+// Start of the message being received.
+static uint32_t     s_rx_msg_start  = 0;
+
+// Initial value of a Luos message CRC.
+#define RX_CRC_INIT         0xFFFF
+
+// Packets held by the simulated BLE stack, oldest first.
+static uint8_t      s_link[LINK_QUEUE_SIZE][LINK_PAYLOAD];
+static uint16_t     s_link_size[LINK_QUEUE_SIZE];
+static uint8_t      s_link_head     = 0;
+static uint8_t      s_link_nb       = 0;
+
+// Packets the simulated BLE stack refuses next, busy with another procedure.
+static uint8_t      s_link_busy_nb  = 0;
+
+// ATT payload of the link, and function called when it changes.
+static uint16_t         s_att_payload       = LINK_PAYLOAD;
+static att_payload_cb_t s_att_payload_cb    = NULL;
+
+// Last scale given to the Luos timeout.
+static uint32_t     s_timeout_baudrate  = 0;
+static uint32_t     s_timeout_min_us    = 0;
+
+// Shortest Luos timeout (us) on the simulated link.
+#define LINK_INTERVAL_US    (LINK_INTERVAL * 1250)
+#define TIMEOUT_MIN_US      (COM_TIMEOUT_CONN_EVENTS * LINK_INTERVAL_US  \
+                             * (LINK_LATENCY + 1))
+#if (COM_TX_COALESCING != DISABLE)                                      \
+    && (COM_TX_FLUSH_DEADLINE * 1000 > TIMEOUT_MIN_US)
+#define TIMEOUT_FLOOR_US    (COM_TX_FLUSH_DEADLINE * 1000)
+#else
+#define TIMEOUT_FLOOR_US    TIMEOUT_MIN_US
+#endif /* COM_TX_COALESCING && COM_TX_FLUSH_DEADLINE */
+
+// Buffers given by the accepted messages, and released in zero copy mode.
+static uint32_t     s_tx_buffers    = 0;
+static uint32_t     s_released      = 0;
+
+context_t                   ctx;
+volatile int                g_nvic_pending_irq  = -1;
+app_sched_event_handler_t   g_sched_pending     = NULL;
+
+/*      STATIC FUNCTIONS                                            */
+
+static void fail(const char* reason)
+{
+    printf("FAIL: %s\n", reason);
+    exit(EXIT_FAILURE);
+}
+
+// Closes the message being received.
+static void rx_msg_end(void)
+{
+    if (s_rx_log.msg_nb == LOG_MSG_NB)
+    {
+        fail("too many received messages");
+    }
+
+    #if (COM_RX_FUSED_CRC != DISABLE)
+    // The CRC computed on reception, before its reset by the COM layer.
+    uint16_t crc = RX_CRC_INIT;
+    for (uint32_t byte_idx = s_rx_msg_start; byte_idx + 2 < s_rx_log.size;
+         byte_idx++)
+    {
+        LuosHAL_ComputeCRC(&s_rx_log.bytes[byte_idx], (uint8_t*)&crc);
+    }
+    if (LuosHAL_ComGetRxCRC() != crc)
+    {
+        fail("fused CRC differs from LuosHAL_ComputeCRC");
+    }
+    #endif /* COM_RX_FUSED_CRC */
+
+    s_rx_log.msg_start[s_rx_log.msg_nb] = s_rx_msg_start;
+    s_rx_log.msg_size[s_rx_log.msg_nb]  = s_rx_log.size - s_rx_msg_start;
+    s_rx_log.msg_nb++;
+    s_rx_msg_start = s_rx_log.size;
+}
+
+static void rx_bytes(const uint8_t* data, uint16_t size)
+{
+    if (s_rx_log.size + size > LOG_SIZE)
+    {
+        fail("too many received bytes");
+    }
+    memcpy(&s_rx_log.bytes[s_rx_log.size], data, size);
+    s_rx_log.size += size;
+}
+
+static void rx_byte_callback(volatile uint8_t* data)
+{
+    uint8_t byte = *data;
+    rx_bytes(&byte, 1);
+}
+
+// Runs the deferred reception, as its interrupt or the main loop would.
+static void rx_deferred_run(void)
+{
+    #if (COM_RX_DEFERRED == COM_RX_DEFER_SWI)
+    if (g_nvic_pending_irq == COM_RX_SWI_IRQ)
+    {
+        g_nvic_pending_irq = -1;
+        COM_RX_SWI_IRQHANDLER();
+    }
+    #elif (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+    app_sched_event_handler_t handler = g_sched_pending;
+    g_sched_pending = NULL;
+    if (handler != NULL)
+    {
+        handler(NULL, 0);
+    }
+    #endif /* COM_RX_DEFERRED */
+}
+
+// The BLE stack sends count packets: the peer receives them.
+static void link_deliver(uint8_t count)
+{
+    for (uint8_t packet_idx = 0; packet_idx < count; packet_idx++)
+    {
+        com_rx_packet(s_link[s_link_head], s_link_size[s_link_head]);
+        s_link_head = (s_link_head + 1) % LINK_QUEUE_SIZE;
+        s_link_nb--;
+        if ((packet_idx + 1) % RX_BURST_MAX == 0)
+        {
+            rx_deferred_run();
+        }
+    }
+    rx_deferred_run();
+    com_tx_complete(count);
+}
+
+// Sends a random message, logged if accepted.
+static void tx_random_msg(void)
+{
+    uint16_t size = 2 + rand() % 40;
+    switch (rand() % 8)
+    {
+    case 0:
+        size = 1;   // Luos ACK
+        break;
+    case 1:
+        size = 2 + rand() % (MSG_SIZE_MAX - 1);
+        break;
+    case 2:
+        size = LINK_PAYLOAD - 2;   // Exactly one record
+        break;
+    default:
+        break;
+    }
+
+    if ((s_tx_log.size + size > LOG_SIZE) || (s_tx_log.msg_nb == LOG_MSG_NB))
+    {
+        return;
+    }
+
+    uint8_t* data = &s_tx_log.bytes[s_tx_log.size];
+    for (uint16_t byte_idx = 0; byte_idx < size; byte_idx++)
+    {
+        data[byte_idx] = (uint8_t)rand();
+    }
+
+    uint8_t accepted;
+    uint8_t buffer_nb = 1;
+    if (rand() % 2)
+    {
+        // Three segments, any of them possibly empty.
+        uint16_t cut1 = rand() % (size + 1);
+        uint16_t cut2 = cut1 + rand() % (size - cut1 + 1);
+        com_segment_t segments[3] =
+        {
+            {.data = data,          .size = cut1},
+            {.data = data + cut1,   .size = cut2 - cut1},
+            {.data = data + cut2,   .size = size - cut2},
+        };
+        accepted = LuosHAL_ComTransmitV(segments, 3);
+
+        buffer_nb = 0;
+        for (uint8_t seg_idx = 0; seg_idx < 3; seg_idx++)
+        {
+            buffer_nb += (segments[seg_idx].size != 0);
+        }
+    }
+    else
+    {
+        accepted = LuosHAL_ComTransmit(data, size);
+    }
+
+    if (accepted)
+    {
+        s_tx_log.msg_start[s_tx_log.msg_nb] = s_tx_log.size;
+        s_tx_log.msg_size[s_tx_log.msg_nb]  = size;
+        s_tx_log.msg_nb++;
+        s_tx_log.size += size;
+        s_tx_buffers += buffer_nb;
+    }
+}
+
+/* Compares the sent and received messages of one lane: control ones if
+** control is true, bulk ones otherwise.
+*/
+static bool lane_check(bool control)
+{
+    uint32_t tx_idx = 0;
+    uint32_t rx_idx = 0;
+
+    while (true)
+    {
+        while ((tx_idx < s_tx_log.msg_nb)
+               && ((s_tx_log.msg_size[tx_idx] <= COM_TX_CONTROL_SIZE_MAX)
+                   != control))
+        {
+            tx_idx++;
+        }
+        while ((rx_idx < s_rx_log.msg_nb)
+               && ((s_rx_log.msg_size[rx_idx] <= COM_TX_CONTROL_SIZE_MAX)
+                   != control))
+        {
+            rx_idx++;
+        }
+
+        if ((tx_idx == s_tx_log.msg_nb) || (rx_idx == s_rx_log.msg_nb))
+        {
+            return (tx_idx == s_tx_log.msg_nb)
+                   && (rx_idx == s_rx_log.msg_nb);
+        }
+
+        uint32_t size = s_tx_log.msg_size[tx_idx];
+        if ((s_rx_log.msg_size[rx_idx] != size)
+            || (memcmp(&s_tx_log.bytes[s_tx_log.msg_start[tx_idx]],
+                       &s_rx_log.bytes[s_rx_log.msg_start[rx_idx]],
+                       size) != 0))
+        {
+            return false;
+        }
+        tx_idx++;
+        rx_idx++;
+    }
+}
+
+#if (COM_RX_MSG_SIZE_MAX != 0)
+/* Sends a message in two packets, the given ticks apart: returns true if
+** the message was delivered, false if it expired.
+*/
+static bool msg_split_send(uint32_t ticks)
+{
+    // One byte records: [flags][size][data], START then END.
+    static const uint8_t start[]    = {0x01, 1, 0xA5};
+    static const uint8_t end[]      = {0x02, 1, 0x5A};
+
+    const com_stats_t*  stats       = LuosHAL_ComGetStats();
+    uint32_t            expired_nb  = stats->rx_msg_expired;
+
+    com_rx_packet(start, sizeof(start));
+    rx_deferred_run();
+    app_timer_stub_advance(ticks);
+    com_rx_packet(end, sizeof(end));
+    rx_deferred_run();
+
+    return stats->rx_msg_expired == expired_nb;
+}
+
+/* Checks the reassembly deadline: the shortest Luos timeout per fragment
+** of the longest message, on the simulated link.
+*/
+static void msg_deadline_check(void)
+{
+    const uint64_t fragment_nb = (COM_RX_MSG_SIZE_MAX + LINK_PAYLOAD - 3)
+                                 / (LINK_PAYLOAD - 2);
+    uint64_t       deadline    = (fragment_nb * TIMEOUT_FLOOR_US
+                                  * APP_TIMER_CLOCK_FREQ + 999999)
+                                 / 1000000;
+    if (deadline < APP_TIMER_TICKS(COM_RX_MSG_DEADLINE))
+    {
+        deadline = APP_TIMER_TICKS(COM_RX_MSG_DEADLINE);
+    }
+
+    if (!msg_split_send((uint32_t)deadline))
+    {
+        fail("message expired on its deadline");
+    }
+    if (msg_split_send((uint32_t)deadline + 1))
+    {
+        fail("message delivered past its deadline");
+    }
+}
+#endif /* COM_RX_MSG_SIZE_MAX */
+
+/*      LUOS AND HAL STUBS                                          */
+
+void Recep_Timeout(void)
+{
+    rx_msg_end();
+}
+
+void Recep_Reset(void)
+{
+    rx_msg_end();
+}
+
+void test_rx_block(const uint8_t* data, uint16_t size)
+{
+    rx_bytes(data, size);
+}
+
+void test_tx_release(const uint8_t* data)
+{
+    (void)data;
+    s_released++;
+}
+
+void LuosHAL_SetIrqState(uint8_t Enable)
+{
+    (void)Enable;
+}
+
+void LuosHAL_ResetTimeout(uint16_t nbrbit)
+{
+    (void)nbrbit;
+}
+
+void LuosHAL_TimeoutSetScale(uint32_t baudrate, uint32_t min_us)
+{
+    s_timeout_baudrate  = baudrate;
+    s_timeout_min_us    = min_us;
+}
+
+uint16_t ble_att_payload_get(void)
+{
+    return s_att_payload;
+}
+
+void ble_att_payload_cb_register(att_payload_cb_t att_payload_cb)
+{
+    s_att_payload_cb = att_payload_cb;
+}
+
+bool com_link_ready(void)
+{
+    return true;
+}
+
+ret_code_t com_link_send(uint8_t* data, uint16_t size)
+{
+    if (s_link_busy_nb != 0)
+    {
+        s_link_busy_nb--;
+        return NRF_ERROR_BUSY;
+    }
+    if (s_link_nb == LINK_QUEUE_SIZE)
+    {
+        return NRF_ERROR_RESOURCES;
+    }
+    if (rand() % 7 == 0)
+    {
+        // The stack is busy for another reason.
+        return (rand() % 2) ? NRF_ERROR_BUSY : NRF_ERROR_RESOURCES;
+    }
+    if (size > LINK_PAYLOAD)
+    {
+        fail("packet larger than the ATT payload");
+    }
+
+    uint8_t link_idx = (s_link_head + s_link_nb) % LINK_QUEUE_SIZE;
+    memcpy(s_link[link_idx], data, size);
+    s_link_size[link_idx] = size;
+    s_link_nb++;
+
+    return NRF_SUCCESS;
+}
+
+int main(void)
+{
+    srand(1);
+    ctx.rx.callback = rx_byte_callback;
+    com_tx_init(LINK_QUEUE_SIZE);
+    com_rx_init();
+
+    // Connection, then the ATT MTU exchange.
+    s_att_payload = 20;
+    com_link_timing(LINK_INTERVAL, LINK_LATENCY);
+    if ((s_timeout_baudrate != 20 * 8 * 1000000 / LINK_INTERVAL_US)
+        || (s_timeout_min_us != TIMEOUT_FLOOR_US))
+    {
+        fail("timeout not scaled to the connection");
+    }
+    s_att_payload = LINK_PAYLOAD;
+    if (s_att_payload_cb == NULL)
+    {
+        fail("ATT MTU updates not followed");
+    }
+    s_att_payload_cb(LINK_PAYLOAD);
+    if (s_timeout_baudrate != LINK_PAYLOAD * 8 * 1000000 / LINK_INTERVAL_US)
+    {
+        fail("timeout not scaled to the ATT MTU");
+    }
+
+    uint8_t byte = 0;
+    com_segment_t segment = {.data = &byte, .size = 1};
+    if ((LuosHAL_ComTransmitLane(&segment, 1, COM_LANE_NB) != 0)
+        || (LuosHAL_ComGetStats()->tx_rejected != 1))
+    {
+        fail("message accepted in an unknown lane");
+    }
+
+    // Refused with none in flight: no completion comes to retry it.
+    s_link_busy_nb = 3;
+    tx_random_msg();
+    for (uint32_t round = 0; (round < DRAIN_ROUND_NB) && (s_link_nb == 0);
+         round++)
+    {
+        app_timer_stub_advance(ROUND_TICKS);
+    }
+    if ((s_link_nb == 0) || (s_link_busy_nb != 0))
+    {
+        fail("refused packet never sent again");
+    }
+    link_deliver(s_link_nb);
+
+    for (uint32_t round = 0; round < ROUND_NB; round++)
+    {
+        app_timer_stub_advance(ROUND_TICKS);
+
+        if (rand() % TX_ROUND_RATIO == 0)
+        {
+            tx_random_msg();
+        }
+        else if (s_link_nb != 0)
+        {
+            link_deliver(1 + rand() % s_link_nb);
+        }
+    }
+
+    for (uint32_t round = 0; round < DRAIN_ROUND_NB; round++)
+    {
+        app_timer_stub_advance(ROUND_TICKS);
+
+        if (s_link_nb != 0)
+        {
+            link_deliver(s_link_nb);
+        }
+    }
+
+    const com_stats_t* stats = LuosHAL_ComGetStats();
+    printf("%lu messages, %lu bytes in %u packets of %u records\n",
+           (unsigned long)s_tx_log.msg_nb, (unsigned long)s_tx_log.size,
+           stats->tx_packets, stats->tx_records);
+    printf("%u retries, %u stalls, %u ACKs (%u piggybacked)\n",
+           stats->tx_retries, stats->tx_stalls, stats->tx_acks,
+           stats->tx_acks_piggybacked);
+    printf("%u messages received, %u dropped, %u expired, %u packets lost\n",
+           stats->rx_messages, stats->rx_msg_dropped, stats->rx_msg_expired,
+           stats->rx_dropped);
+
+    if ((s_rx_log.size != s_tx_log.size)
+        || (s_rx_log.msg_nb != s_tx_log.msg_nb))
+    {
+        fail("messages lost or split");
+    }
+    if (!lane_check(true) || !lane_check(false))
+    {
+        fail("messages corrupted or out of order");
+    }
+    if ((stats->rx_msg_dropped != 0) || (stats->rx_dropped != 0))
+    {
+        fail("messages dropped");
+    }
+    #if (COM_TX_ZERO_COPY != DISABLE)
+    if (s_released != s_tx_buffers)
+    {
+        fail("zero copy buffers not released");
+    }
+    #endif /* COM_TX_ZERO_COPY */
+
+    #if (COM_RX_MSG_SIZE_MAX != 0)
+    msg_deadline_check();
+    #endif /* COM_RX_MSG_SIZE_MAX */
+
+    printf("OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/* Host stress test of the COM queue ring (com/common/luos_hal_com_queue.c):
+** one producer thread and one consumer thread push variable size messages
+** through a small ring, wrapping its descriptors and its arena over and
+** over, and the consumer checks each message size, content and order.
+**
+** Build and run from the repository root:
+**   gcc -std=gnu99 -O2 -Wall -Wextra -fsanitize=thread -pthread       \
+**       -Itest/stub -I. -Icom -Icom/common -Iflash -Itimer -Iptp       \
+**       -Icrc -Iprobe test/com_queue_stress.c test/stub/app_timer.c    \
+**       com/common/luos_hal_com_queue.c -o com_queue_stress
+**   ./com_queue_stress
+** Add -DMSG_NB=<n> to change the number of messages.
+*/
+
+/*      INCLUDES                                                    */
+
+// C STANDARD
+#include <pthread.h>        // pthread_*
+#include <sched.h>          // sched_yield
+#include <stdint.h>         // uint8_t, uint16_t, uint32_t
+#include <stdio.h>          // printf
+#include <stdlib.h>         // exit, EXIT_*
+#include <string.h>         // memcmp
+
+// CUSTOM
+#include "luos_hal_com_queue.h"     // COM_QUEUE_DEF, com_queue_*
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
+// Number of messages sent through the ring.
+#ifndef MSG_NB
+#define MSG_NB          3000000UL
+#endif
+
+/* Largest message: half the arena, the most a drained ring is sure to
+** fit, see com_queue_reserve.
+*/
+#define MSG_SIZE_MAX    48
+
+// Ring under test: 7 descriptors, 97 arena bytes.
+COM_QUEUE_DEF(s_queue, 7, 97);
+
+/*      STATIC FUNCTIONS                                            */
+
+// Size of the given message, 1 to MSG_SIZE_MAX bytes.
+static uint16_t msg_size(uint32_t seq)
+{
+    return 1 + ((seq * 2654435761UL) >> 7) % MSG_SIZE_MAX;
+}
+
+// Content of the given message.
+static void msg_fill(uint32_t seq, uint8_t* data, uint16_t size)
+{
+    for (uint16_t i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)(seq * 31 + i);
+    }
+}
+
+static void* producer(void* arg)
+{
+    uint8_t data[MSG_SIZE_MAX];
+
+    for (uint32_t seq = 0; seq < MSG_NB;)
+    {
+        uint16_t size = msg_size(seq);
+        if (!com_queue_reserve(&s_queue, 1, size))
+        {
+            sched_yield();
+            continue;
+        }
+
+        // Copied in two parts, as segmented messages are.
+        msg_fill(seq, data, size);
+        com_queue_copy(&s_queue, 0, data, size / 2);
+        com_queue_copy(&s_queue, size / 2, data + size / 2,
+                       size - size / 2);
+
+        com_tx_desc_t* desc = com_queue_reserved(&s_queue, 0);
+        desc->size  = size;
+        desc->flags = COM_QUEUE_MSG;
+
+        com_queue_commit(&s_queue);
+        seq++;
+    }
+
+    return arg;
+}
+
+static void* consumer(void* arg)
+{
+    uint8_t data[MSG_SIZE_MAX];
+
+    for (uint32_t seq = 0; seq < MSG_NB;)
+    {
+        com_tx_desc_t* desc = com_queue_peek(&s_queue);
+        if (desc == NULL)
+        {
+            sched_yield();
+            continue;
+        }
+
+        uint16_t size = msg_size(seq);
+        msg_fill(seq, data, size);
+        if ((desc->size != size) || (desc->flags != COM_QUEUE_MSG)
+            || (memcmp(desc->data, data, size) != 0))
+        {
+            printf("FAIL: message %lu lost or corrupted\n",
+                   (unsigned long)seq);
+            exit(EXIT_FAILURE);
+        }
+
+        com_queue_pop(&s_queue);
+        seq++;
+    }
+
+    return arg;
+}
+
+int main(void)
+{
+    pthread_t producer_thread;
+    pthread_t consumer_thread;
+
+    pthread_create(&consumer_thread, NULL, consumer, NULL);
+    pthread_create(&producer_thread, NULL, producer, NULL);
+    pthread_join(producer_thread, NULL);
+    pthread_join(consumer_thread, NULL);
+
+    if (com_queue_peek(&s_queue) != NULL)
+    {
+        printf("FAIL: ring not empty\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("OK: %lu messages, %u descriptors and %u arena bytes at most\n",
+           (unsigned long)MSG_NB, com_queue_max(&s_queue),
+           com_queue_arena_max(&s_queue));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+/* Host check and benchmark of the CRC profiles (crc/luos_hal_crc.c): both
+** LuosHAL_ComputeCRC, one call per byte, and LuosHAL_ComputeCRCBlock are
+** compared with the original bitwise loop on random buffers, lengths and
+** seeds, then timed in cycles per byte (x86 time stamp counter, or
+** nanoseconds per byte on other hosts).
+**
+** The profile is a build option, so build and run once per profile from
+** the repository root:
+**   for profile in 0 1 2 3; do                                         \
+**       gcc -std=gnu99 -O2 -Wall -Wextra -DCRC_PROFILE=$profile        \
+**           -Itest/stub -I. -Icom -Iflash -Itimer -Iptp -Icrc -Iprobe  \
+**           test/crc_bench.c crc/luos_hal_crc.c -o crc_bench &&        \
+**       ./crc_bench;                                                   \
+**   done
+** Add -DCRC_SLICE_NB=<2 to 8> to size the slice profile (3).
+*/
+
+/*      INCLUDES                                                    */
+
+#include "luos_hal.h"
+
+// C STANDARD
+#include <stdint.h>         // uint8_t, uint16_t, uint32_t, uint64_t
+#include <stdio.h>          // printf
+#include <stdlib.h>         // rand, srand, EXIT_*
+#include <time.h>           // clock_gettime
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>      // __rdtsc
+#define BENCH_UNIT          "cycles"
+#else
+#define BENCH_UNIT          "ns"
+#endif
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
+// Random buffer the CRCs are computed on.
+#define BUFFER_SIZE         60000
+
+// Random length and seed checks.
+#define CHECK_NB            2000
+
+// Passes over the buffer per timing.
+#define BENCH_PASSES        50
+
+static uint8_t s_buffer[BUFFER_SIZE];
+
+/*      STATIC FUNCTIONS                                            */
+
+// Original bitwise loop, the reference.
+static uint16_t crc_reference(uint16_t crc, const uint8_t* data, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t j = 0; j < 8; ++j)
+        {
+            uint16_t mix = crc & 0x8000;
+            crc = (crc << 1);
+            if (mix)
+                crc = crc ^ CRC_POLYNOMIAL;
+        }
+    }
+    return crc;
+}
+
+static uint16_t crc_per_byte(uint16_t crc, uint8_t* data, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        LuosHAL_ComputeCRC(&data[i], (uint8_t*)&crc);
+    }
+    return crc;
+}
+
+static uint16_t crc_block(uint16_t crc, uint8_t* data, uint32_t size)
+{
+    while (size > 0)
+    {
+        uint16_t block = (size > UINT16_MAX) ? UINT16_MAX : (uint16_t)size;
+        LuosHAL_ComputeCRCBlock(data, block, (uint8_t*)&crc);
+        data += block;
+        size -= block;
+    }
+    return crc;
+}
+
+// Current time, in BENCH_UNIT.
+static uint64_t bench_now(void)
+{
+    #if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+    #else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    #endif
+}
+
+// Prints the time per byte of the given CRC function over the buffer.
+static void bench(const char* name,
+                  uint16_t (*crc_fn)(uint16_t, uint8_t*, uint32_t))
+{
+    volatile uint16_t sink = 0;
+    uint64_t start = bench_now();
+    for (uint32_t pass = 0; pass < BENCH_PASSES; pass++)
+    {
+        sink ^= crc_fn((uint16_t)pass, s_buffer, BUFFER_SIZE);
+    }
+    uint64_t elapsed = bench_now() - start;
+    (void)sink;
+
+    printf("  %-24s %6.2f %s/byte\n", name,
+           (double)elapsed / ((double)BENCH_PASSES * BUFFER_SIZE),
+           BENCH_UNIT);
+}
+
+// Adapts the reference to the benchmark signature.
+static uint16_t crc_bitwise(uint16_t crc, uint8_t* data, uint32_t size)
+{
+    return crc_reference(crc, data, size);
+}
+
+int main(void)
+{
+    srand(1);
+    for (uint32_t i = 0; i < BUFFER_SIZE; i++)
+    {
+        s_buffer[i] = (uint8_t)rand();
+    }
+
+    for (uint32_t check = 0; check < CHECK_NB; check++)
+    {
+        uint32_t offset = rand() % BUFFER_SIZE;
+        uint32_t size   = rand() % (BUFFER_SIZE - offset + 1);
+        uint16_t seed   = (uint16_t)rand();
+
+        uint16_t expected = crc_reference(seed, &s_buffer[offset], size);
+        if ((crc_per_byte(seed, &s_buffer[offset], size) != expected)
+            || (crc_block(seed, &s_buffer[offset], size) != expected))
+        {
+            printf("FAIL: CRC_PROFILE %d, offset %u, size %u, seed 0x%04X\n",
+                   CRC_PROFILE, offset, size, seed);
+            return EXIT_FAILURE;
+        }
+    }
+
+    #if (CRC_PROFILE == CRC_PROFILE_SLICE)
+    printf("CRC_PROFILE %d (slice by %d): %d checks OK\n",
+           CRC_PROFILE, CRC_SLICE_NB, CHECK_NB);
+    #else
+    printf("CRC_PROFILE %d: %d checks OK\n", CRC_PROFILE, CHECK_NB);
+    #endif
+    bench("bitwise loop", crc_bitwise);
+    bench("LuosHAL_ComputeCRC", crc_per_byte);
+    bench("LuosHAL_ComputeCRCBlock", crc_block);
+
+    return EXIT_SUCCESS;
+}
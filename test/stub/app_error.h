@@ -0,0 +1,19 @@
+#ifndef APP_ERROR_H
+#define APP_ERROR_H
+
+// Host stub of the nRF5 SDK error check: fails the test on any error.
+
+// C STANDARD
+#include <stdio.h>          // printf
+#include <stdlib.h>         // exit, EXIT_FAILURE
+
+#define APP_ERROR_CHECK(ERR_CODE)   do {                                \
+        if ((ERR_CODE) != 0)                                            \
+        {                                                               \
+            printf("FAIL: error %u at %s:%d\n", (unsigned)(ERR_CODE),   \
+                   __FILE__, __LINE__);                                 \
+            exit(EXIT_FAILURE);                                         \
+        }                                                               \
+    } while (0)
+
+#endif /* ! APP_ERROR_H */
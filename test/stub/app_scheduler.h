@@ -0,0 +1,35 @@
+#ifndef APP_SCHEDULER_H
+#define APP_SCHEDULER_H
+
+/* Host stub of the nRF5 SDK app_scheduler: events are only recorded, for
+** the test to run them from its main loop.
+*/
+
+// C STANDARD
+#include <stddef.h>         // NULL
+#include <stdint.h>         // uint16_t, uint32_t
+
+// STUBS
+#include "sdk_errors.h"     // NRF_SUCCESS, NRF_ERROR_RESOURCES
+
+typedef void (*app_sched_event_handler_t)(void* event_data,
+                                          uint16_t event_size);
+
+// Event waiting to be run, NULL if none.
+extern app_sched_event_handler_t g_sched_pending;
+
+static inline uint32_t app_sched_event_put(void const* event_data,
+                                           uint16_t event_size,
+                                           app_sched_event_handler_t handler)
+{
+    (void)event_data;
+    (void)event_size;
+    if (g_sched_pending != NULL)
+    {
+        return NRF_ERROR_RESOURCES;
+    }
+    g_sched_pending = handler;
+    return NRF_SUCCESS;
+}
+
+#endif /* ! APP_SCHEDULER_H */
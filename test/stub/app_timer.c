@@ -0,0 +1,97 @@
+#include "app_timer.h"
+
+/*      INCLUDES                                                    */
+
+// C STANDARD
+#include <stddef.h>         // NULL
+#include <stdint.h>         // uint8_t, uint32_t
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
+// Counter mask, as the RTC one.
+#define STUB_CNT_MASK   0xFFFFFF
+
+// Timers created so far.
+#define STUB_TIMER_NB   8
+
+static app_timer_t*     s_timers[STUB_TIMER_NB];
+static uint8_t          s_timer_nb  = 0;
+
+// Counter, not masked.
+static uint32_t         s_cnt       = 0;
+
+ret_code_t app_timer_create(app_timer_id_t const* id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t handler)
+{
+    if (s_timer_nb == STUB_TIMER_NB)
+    {
+        return NRF_ERROR_RESOURCES;
+    }
+
+    app_timer_t* timer  = *id;
+    timer->handler      = handler;
+    timer->mode         = mode;
+    timer->armed        = 0;
+    s_timers[s_timer_nb++] = timer;
+
+    return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_start(app_timer_id_t id, uint32_t ticks, void* context)
+{
+    if (id->armed)
+    {
+        // As the SDK: starting a running timer does nothing.
+        return NRF_SUCCESS;
+    }
+
+    id->period  = ticks;
+    id->expiry  = s_cnt + ticks;
+    id->context = context;
+    id->armed   = 1;
+
+    return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_stop(app_timer_id_t id)
+{
+    id->armed = 0;
+
+    return NRF_SUCCESS;
+}
+
+uint32_t app_timer_cnt_get(void)
+{
+    return s_cnt & STUB_CNT_MASK;
+}
+
+uint32_t app_timer_cnt_diff_compute(uint32_t to, uint32_t from)
+{
+    return (to - from) & STUB_CNT_MASK;
+}
+
+void app_timer_stub_advance(uint32_t ticks)
+{
+    while (ticks-- > 0)
+    {
+        s_cnt++;
+        for (uint8_t timer_idx = 0; timer_idx < s_timer_nb; timer_idx++)
+        {
+            app_timer_t* timer = s_timers[timer_idx];
+            if (!timer->armed || (timer->expiry != s_cnt))
+            {
+                continue;
+            }
+
+            if (timer->mode == APP_TIMER_MODE_REPEATED)
+            {
+                timer->expiry += timer->period;
+            }
+            else
+            {
+                timer->armed = 0;
+            }
+            timer->handler(timer->context);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef APP_TIMER_H
+#define APP_TIMER_H
+
+/* Host stub of the nRF5 SDK app_timer (app_timer.c): a 24 bits counter
+** moved forward by the tests, firing the timers it passes.
+*/
+
+// C STANDARD
+#include <stdint.h>         // uint32_t
+
+// STUBS
+#include "sdk_errors.h"     // ret_code_t
+
+#define APP_TIMER_CLOCK_FREQ            32768
+#define APP_TIMER_CONFIG_RTC_FREQUENCY  0
+#define APP_TIMER_MIN_TIMEOUT_TICKS     5
+#define APP_TIMER_TICKS(MS)             ((uint32_t)(((uint64_t)(MS)     \
+                                         * APP_TIMER_CLOCK_FREQ) / 1000))
+
+typedef enum
+{
+    APP_TIMER_MODE_SINGLE_SHOT,
+    APP_TIMER_MODE_REPEATED,
+} app_timer_mode_t;
+
+typedef void (*app_timer_timeout_handler_t)(void* context);
+
+typedef struct
+{
+    app_timer_timeout_handler_t handler;
+    app_timer_mode_t            mode;
+    uint32_t                    period;
+    uint32_t                    expiry;
+    void*                       context;
+    uint8_t                     armed;
+} app_timer_t;
+
+typedef app_timer_t* app_timer_id_t;
+
+#define APP_TIMER_DEF(ID)                                           \
+static app_timer_t      ID##_data;                                  \
+static app_timer_id_t   ID = &ID##_data
+
+ret_code_t app_timer_create(app_timer_id_t const* id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t handler);
+ret_code_t app_timer_start(app_timer_id_t id, uint32_t ticks, void* context);
+ret_code_t app_timer_stop(app_timer_id_t id);
+uint32_t app_timer_cnt_get(void);
+uint32_t app_timer_cnt_diff_compute(uint32_t to, uint32_t from);
+
+// Moves the counter forward, firing the timers expiring on the way.
+void app_timer_stub_advance(uint32_t ticks);
+
+#endif /* ! APP_TIMER_H */
@@ -0,0 +1,11 @@
+#ifndef APP_UTIL_PLATFORM_H
+#define APP_UTIL_PLATFORM_H
+
+// Host stub of the nRF5 SDK interrupt priorities.
+
+#define APP_IRQ_PRIORITY_HIGH       2
+#define APP_IRQ_PRIORITY_MID        4
+#define APP_IRQ_PRIORITY_LOW        6
+#define APP_IRQ_PRIORITY_LOWEST     7
+
+#endif /* ! APP_UTIL_PLATFORM_H */
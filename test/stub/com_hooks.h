@@ -0,0 +1,14 @@
+#ifndef COM_HOOKS_H
+#define COM_HOOKS_H
+
+/* Declarations of the COM hooks of the loopback test, included through
+** LUOS_COM_HOOKS_HEADER.
+*/
+
+// C STANDARD
+#include <stdint.h>         // uint8_t, uint16_t
+
+void test_rx_block(const uint8_t* data, uint16_t size);
+void test_tx_release(const uint8_t* data);
+
+#endif /* ! COM_HOOKS_H */
@@ -0,0 +1,23 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+// Host stub of the Luos context, with the fields used by the HAL.
+
+// C STANDARD
+#include <stdint.h>         // uint8_t
+
+typedef struct
+{
+    struct
+    {
+        void (*callback)(volatile uint8_t* data);
+    } rx;
+    struct
+    {
+        volatile uint8_t lock;
+    } tx;
+} context_t;
+
+extern context_t ctx;
+
+#endif /* ! CONTEXT_H */
@@ -0,0 +1,8 @@
+#ifndef NRF_BLE_GATT_H
+#define NRF_BLE_GATT_H
+
+// Host stub of the nRF5 SDK GATT module types.
+
+typedef struct nrf_ble_gatt_s nrf_ble_gatt_t;
+
+#endif /* ! NRF_BLE_GATT_H */
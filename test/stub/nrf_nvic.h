@@ -0,0 +1,60 @@
+#ifndef NRF_NVIC_H
+#define NRF_NVIC_H
+
+/* Host stub of the SoftDevice NVIC calls: critical regions do nothing,
+** and a pending interrupt is only recorded, for the test to run its
+** handler.
+*/
+
+// C STANDARD
+#include <stdint.h>         // uint8_t, uint32_t
+
+// STUBS
+#include "sdk_errors.h"     // NRF_SUCCESS
+
+typedef int IRQn_Type;
+
+#define SWI3_EGU3_IRQn      23
+#define RTC2_IRQn           36
+
+// Last interrupt set pending, -1 once handled by the test.
+extern volatile int g_nvic_pending_irq;
+
+static inline uint32_t sd_nvic_critical_region_enter(uint8_t* nested)
+{
+    *nested = 0;
+    return NRF_SUCCESS;
+}
+
+static inline uint32_t sd_nvic_critical_region_exit(uint8_t nested)
+{
+    (void)nested;
+    return NRF_SUCCESS;
+}
+
+static inline uint32_t sd_nvic_SetPriority(IRQn_Type irq, uint32_t prio)
+{
+    (void)irq;
+    (void)prio;
+    return NRF_SUCCESS;
+}
+
+static inline uint32_t sd_nvic_ClearPendingIRQ(IRQn_Type irq)
+{
+    (void)irq;
+    return NRF_SUCCESS;
+}
+
+static inline uint32_t sd_nvic_EnableIRQ(IRQn_Type irq)
+{
+    (void)irq;
+    return NRF_SUCCESS;
+}
+
+static inline uint32_t sd_nvic_SetPendingIRQ(IRQn_Type irq)
+{
+    g_nvic_pending_irq = irq;
+    return NRF_SUCCESS;
+}
+
+#endif /* ! NRF_NVIC_H */
@@ -0,0 +1,94 @@
+#include "nrf_rtc.h"
+
+/*      INCLUDES                                                    */
+
+// STUBS
+#include "nrf_nvic.h"       // sd_nvic_SetPendingIRQ, RTC2_IRQn
+
+NRF_RTC_Type g_rtc2;
+
+// Pends the interrupt of a raised and enabled compare event.
+static void rtc_irq_update(NRF_RTC_Type* rtc)
+{
+    if (rtc->compare_event && (rtc->inten & NRF_RTC_INT_COMPARE0_MASK))
+    {
+        sd_nvic_SetPendingIRQ(RTC2_IRQn);
+    }
+}
+
+void nrf_rtc_task_trigger(NRF_RTC_Type* rtc, nrf_rtc_task_t task)
+{
+    if (task == NRF_RTC_TASK_CLEAR)
+    {
+        rtc->counter = 0;
+    }
+}
+
+void nrf_rtc_prescaler_set(NRF_RTC_Type* rtc, uint32_t prescaler)
+{
+    (void)rtc;
+    (void)prescaler;
+}
+
+void nrf_rtc_int_enable(NRF_RTC_Type* rtc, uint32_t mask)
+{
+    rtc->inten |= mask;
+    rtc_irq_update(rtc);
+}
+
+void nrf_rtc_int_disable(NRF_RTC_Type* rtc, uint32_t mask)
+{
+    rtc->inten &= ~mask;
+}
+
+void nrf_rtc_event_clear(NRF_RTC_Type* rtc, nrf_rtc_event_t event)
+{
+    (void)event;
+    rtc->compare_event = false;
+}
+
+bool nrf_rtc_event_pending(NRF_RTC_Type* rtc, nrf_rtc_event_t event)
+{
+    (void)event;
+    return rtc->compare_event;
+}
+
+void nrf_rtc_cc_set(NRF_RTC_Type* rtc, uint32_t channel, uint32_t value)
+{
+    (void)channel;
+    rtc->cc           = value & RTC_COUNTER_COUNTER_Msk;
+    rtc->compare_skip = (rtc->cc == ((rtc->counter + 1)
+                                     & RTC_COUNTER_COUNTER_Msk));
+}
+
+uint32_t nrf_rtc_counter_get(NRF_RTC_Type* rtc)
+{
+    uint32_t counter = rtc->counter;
+
+    // Another context runs right after the read.
+    uint32_t preempt_ticks = rtc->preempt_ticks;
+    rtc->preempt_ticks = 0;
+    nrf_rtc_stub_advance(rtc, preempt_ticks);
+
+    return counter;
+}
+
+void nrf_rtc_stub_advance(NRF_RTC_Type* rtc, uint32_t ticks)
+{
+    while (ticks-- > 0)
+    {
+        rtc->counter = (rtc->counter + 1) & RTC_COUNTER_COUNTER_Msk;
+        if (rtc->counter == rtc->cc)
+        {
+            if (rtc->compare_skip)
+            {
+                rtc->compare_skip = false;
+            }
+            else
+            {
+                rtc->compare_event = true;
+                rtc_irq_update(rtc);
+            }
+        }
+    }
+}
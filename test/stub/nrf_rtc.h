@@ -0,0 +1,58 @@
+#ifndef NRF_RTC_H
+#define NRF_RTC_H
+
+/* Host stub of the nRF5 SDK RTC HAL (nrf_rtc.c): one RTC with a 24 bits
+** counter and a compare channel, moved forward by the tests. As on the
+** target, a compare value one tick ahead of the counter may not match.
+*/
+
+// C STANDARD
+#include <stdbool.h>        // bool
+#include <stdint.h>         // uint32_t
+
+typedef struct
+{
+    uint32_t    counter;
+    uint32_t    cc;
+    uint32_t    inten;
+    bool        compare_event;
+    bool        compare_skip;
+
+    // Ticks the counter jumps right after its next read.
+    uint32_t    preempt_ticks;
+} NRF_RTC_Type;
+
+extern NRF_RTC_Type g_rtc2;
+
+#define NRF_RTC2                    (&g_rtc2)
+
+#define NRF_RTC_INT_COMPARE0_MASK   (1UL << 16)
+#define RTC_COUNTER_COUNTER_Msk     0xFFFFFFUL
+
+typedef enum
+{
+    NRF_RTC_TASK_START,
+    NRF_RTC_TASK_STOP,
+    NRF_RTC_TASK_CLEAR,
+} nrf_rtc_task_t;
+
+typedef enum
+{
+    NRF_RTC_EVENT_COMPARE_0,
+} nrf_rtc_event_t;
+
+void nrf_rtc_task_trigger(NRF_RTC_Type* rtc, nrf_rtc_task_t task);
+void nrf_rtc_prescaler_set(NRF_RTC_Type* rtc, uint32_t prescaler);
+void nrf_rtc_int_enable(NRF_RTC_Type* rtc, uint32_t mask);
+void nrf_rtc_int_disable(NRF_RTC_Type* rtc, uint32_t mask);
+void nrf_rtc_event_clear(NRF_RTC_Type* rtc, nrf_rtc_event_t event);
+bool nrf_rtc_event_pending(NRF_RTC_Type* rtc, nrf_rtc_event_t event);
+void nrf_rtc_cc_set(NRF_RTC_Type* rtc, uint32_t channel, uint32_t value);
+uint32_t nrf_rtc_counter_get(NRF_RTC_Type* rtc);
+
+/* Moves the counter forward, raising the compare event, and pending the
+** RTC2 interrupt if enabled, when the compare value is reached.
+*/
+void nrf_rtc_stub_advance(NRF_RTC_Type* rtc, uint32_t ticks);
+
+#endif /* ! NRF_RTC_H */
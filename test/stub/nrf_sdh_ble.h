@@ -0,0 +1,11 @@
+#ifndef NRF_SDH_BLE_H
+#define NRF_SDH_BLE_H
+
+// Host stub of the nRF5 SDK BLE event dispatch types.
+
+typedef struct ble_evt_s ble_evt_t;
+
+typedef void (*nrf_sdh_ble_evt_handler_t)(ble_evt_t const* event,
+                                          void* context);
+
+#endif /* ! NRF_SDH_BLE_H */
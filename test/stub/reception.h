@@ -0,0 +1,9 @@
+#ifndef RECEPTION_H
+#define RECEPTION_H
+
+// Host stub of the Luos reception entry points used by the HAL.
+
+void Recep_Timeout(void);
+void Recep_Reset(void);
+
+#endif /* ! RECEPTION_H */
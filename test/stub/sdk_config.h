@@ -0,0 +1,8 @@
+#ifndef SDK_CONFIG_H
+#define SDK_CONFIG_H
+
+// Host stub of the application SDK configuration.
+
+#define NRF_SDH_BLE_GATT_MAX_MTU_SIZE   247
+
+#endif /* ! SDK_CONFIG_H */
@@ -0,0 +1,17 @@
+#ifndef SDK_ERRORS_H
+#define SDK_ERRORS_H
+
+// Host stub of the nRF5 SDK error codes used by the HAL.
+
+// C STANDARD
+#include <stdint.h>         // uint32_t
+
+typedef uint32_t ret_code_t;
+
+#define NRF_SUCCESS                 0
+#define NRF_ERROR_NOT_FOUND         5
+#define NRF_ERROR_INVALID_STATE     8
+#define NRF_ERROR_BUSY              17
+#define NRF_ERROR_RESOURCES         19
+
+#endif /* ! SDK_ERRORS_H */
@@ -0,0 +1,216 @@
+/* Host test of the RTC backend of the Luos timeout (timer/luos_hal_timer.c)
+** over a simulated RTC2: each timeout must reach Recep_Timeout once, on
+** its deadline, including when another context delays LuosHAL_ResetTimeout
+** between its counter read and its compare write, and across the counter
+** wrap. A reset or a cancel must drop the previous deadline.
+**
+** Build and run from the repository root:
+**   gcc -std=gnu99 -O2 -Wall -Wextra -fsanitize=address,undefined     \
+**       -DLUOS_TIMER_BACKEND=0x02 -Itest/stub -I. -Icom -Icom/common  \
+**       -Iflash -Itimer -Iptp -Icrc -Iprobe test/timer_rtc.c           \
+**       test/stub/nrf_rtc.c timer/luos_hal_timer.c -o timer_rtc
+**   ./timer_rtc
+** and again with -DCOM_RX_DEFERRED=2, Luos reception in the main loop.
+*/
+
+/*      INCLUDES                                                    */
+
+#include "luos_hal.h"
+
+// C STANDARD
+#include <stdbool.h>        // bool
+#include <stdint.h>         // uint16_t, uint32_t
+#include <stdio.h>          // printf
+#include <stdlib.h>         // exit, EXIT_*
+
+// STUBS
+#include "app_scheduler.h"  // g_sched_pending
+#include "context.h"        // ctx
+#include "nrf_nvic.h"       // g_nvic_pending_irq, RTC2_IRQn
+#include "nrf_rtc.h"        // g_rtc2, nrf_rtc_stub_advance
+
+// CUSTOM
+#include "luos_hal_timer.h" // LuosHAL_Timeout*, LuosHAL_ResetTimeout
+
+#if (LUOS_TIMER_BACKEND != LUOS_TIMER_RTC)
+#error "Build with -DLUOS_TIMER_BACKEND=0x02"
+#endif /* LUOS_TIMER_BACKEND */
+
+void RTC2_IRQHandler(void);
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
+// Ticks waited for a timeout which must not come.
+#define TICKS_QUIET         1000
+
+static uint32_t     s_timeout_nb    = 0;
+
+context_t                   ctx;
+volatile int                g_nvic_pending_irq  = -1;
+app_sched_event_handler_t   g_sched_pending     = NULL;
+
+/*      STATIC FUNCTIONS                                            */
+
+static void fail(const char* reason)
+{
+    printf("FAIL: %s\n", reason);
+    exit(EXIT_FAILURE);
+}
+
+// Runs the pending interrupt and scheduler event, as the target would.
+static void pending_run(void)
+{
+    if (g_nvic_pending_irq == RTC2_IRQn)
+    {
+        g_nvic_pending_irq = -1;
+        RTC2_IRQHandler();
+    }
+
+    app_sched_event_handler_t handler = g_sched_pending;
+    g_sched_pending = NULL;
+    if (handler != NULL)
+    {
+        handler(NULL, 0);
+    }
+}
+
+/* Moves the RTC forward tick by tick: returns the ticks elapsed until
+** the first timeout, 0 if none came within max_ticks.
+*/
+static uint32_t timeout_wait(uint32_t max_ticks)
+{
+    uint32_t timeout_nb = s_timeout_nb;
+
+    pending_run();
+    if (s_timeout_nb != timeout_nb)
+    {
+        return 0;
+    }
+
+    for (uint32_t tick = 1; tick <= max_ticks; tick++)
+    {
+        nrf_rtc_stub_advance(NRF_RTC2, 1);
+        pending_run();
+        if (s_timeout_nb != timeout_nb)
+        {
+            return tick;
+        }
+    }
+    return 0;
+}
+
+// Checks a single timeout comes after the given ticks, none right after.
+static void timeout_check(uint32_t ticks, const char* reason)
+{
+    uint32_t timeout_nb = s_timeout_nb;
+
+    if ((timeout_wait(ticks + 1) != ticks)
+        || (timeout_wait(TICKS_QUIET) != 0)
+        || (s_timeout_nb != timeout_nb + 1))
+    {
+        fail(reason);
+    }
+}
+
+/*      LUOS AND HAL STUBS                                          */
+
+void Recep_Timeout(void)
+{
+    s_timeout_nb++;
+}
+
+void Recep_Reset(void)
+{
+}
+
+void LuosHAL_SetIrqState(uint8_t Enable)
+{
+    (void)Enable;
+}
+
+void timer_irq_handler(void)
+{
+}
+
+int main(void)
+{
+    ctx.tx.lock = true;
+
+    LuosHAL_TimeoutInit();
+
+    // One bit time per RTC tick.
+    LuosHAL_TimeoutSetScale(32768, 0);
+
+    LuosHAL_ResetTimeout(10);
+    timeout_check(10, "timeout not on its deadline");
+
+    // Pushed later.
+    LuosHAL_ResetTimeout(10);
+    timeout_wait(5);
+    LuosHAL_ResetTimeout(10);
+    timeout_check(10, "timeout not moved by a reset");
+
+    // Cancelled.
+    LuosHAL_ResetTimeout(10);
+    LuosHAL_ResetTimeout(0);
+    if (timeout_wait(TICKS_QUIET) != 0)
+    {
+        fail("cancelled timeout fired");
+    }
+
+    // Across the counter wrap.
+    g_rtc2.counter = RTC_COUNTER_COUNTER_Msk - 4;
+    LuosHAL_ResetTimeout(10);
+    timeout_check(10, "timeout lost on the counter wrap");
+
+    // Deadline passed before the compare write.
+    g_rtc2.preempt_ticks = 5;
+    LuosHAL_ResetTimeout(3);
+    timeout_check(0, "timeout lost when delayed past its deadline");
+
+    // Deadline one tick ahead after the compare write.
+    g_rtc2.preempt_ticks = 1;
+    LuosHAL_ResetTimeout(2);
+    timeout_check(0, "timeout lost when delayed close to its deadline");
+
+    // Delayed past its deadline, then cancelled before its interrupt.
+    g_rtc2.preempt_ticks = 5;
+    LuosHAL_ResetTimeout(3);
+    LuosHAL_ResetTimeout(0);
+    if (timeout_wait(TICKS_QUIET) != 0)
+    {
+        fail("cancelled timeout fired after a delay");
+    }
+
+    #if (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+    // Fired, then outdated by a reset before the main loop handles it.
+    uint32_t timeout_nb = s_timeout_nb;
+    LuosHAL_ResetTimeout(5);
+    for (uint32_t tick = 0; tick < 5; tick++)
+    {
+        nrf_rtc_stub_advance(NRF_RTC2, 1);
+        if (g_nvic_pending_irq == RTC2_IRQn)
+        {
+            g_nvic_pending_irq = -1;
+            RTC2_IRQHandler();
+        }
+    }
+    if ((g_sched_pending == NULL) || (s_timeout_nb != timeout_nb))
+    {
+        fail("timeout not deferred to the main loop");
+    }
+    LuosHAL_ResetTimeout(10);
+    timeout_check(10, "outdated timeout handed to Luos");
+    #endif /* COM_RX_DEFERRED */
+
+    // No timeout for Luos while it does not wait for a message.
+    ctx.tx.lock = false;
+    LuosHAL_ResetTimeout(10);
+    if (timeout_wait(TICKS_QUIET) != 0)
+    {
+        fail("timeout handed to Luos while unlocked");
+    }
+
+    printf("OK: %lu timeouts\n", (unsigned long)s_timeout_nb);
+    return EXIT_SUCCESS;
+}
@@ -5,7 +5,7 @@
 
 // C STANDARD
 #include <stdbool.h>    // bool
-#include <stdint.h>     // uint16_t
+#include <stdint.h>     // uint16_t, uint32_t, uint64_t
 
 // NRF
 #include "sdk_errors.h" // ret_code_t
@@ -14,27 +14,139 @@
 #include "nrf_log.h"    // NRF_LOG_INFO
 #endif /* DEBUG */
 
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_RTC)
+#include "nrf_nvic.h"   // sd_nvic_*
+#include "nrf_rtc.h"    // NRF_RTC_*, nrf_rtc_*
+#endif /* LUOS_TIMER_RTC */
+
 // NRF APPS
 #include "app_error.h"  // APP_ERROR_CHECK
+
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_RTC)
+#include "app_util_platform.h"  // APP_IRQ_PRIORITY_*
+#endif /* LUOS_TIMER_RTC */
+
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_APP_TIMER)
 #include "app_timer.h"  // APP_TIMER_*, app_timer_*
+#endif /* LUOS_TIMER_APP_TIMER */
+
+#if (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+#include "app_scheduler.h"  // app_sched_event_put
+#endif /* COM_RX_DEFERRED */
 
 // LUOS
 #include "context.h"    // ctx
 #include "reception.h"  // Recep_Timeout
 
+#if (LUOS_TIMER_STATS != DISABLE)
+// CUSTOM
+#include "luos_hal_systick.h"   // LuosHAL_GetTimeUs
+#endif /* LUOS_TIMER_STATS */
+
+/*      STATIC VARIABLES & CONSTANTS                                */
+
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_RTC)
+
+// RTC counter frequency, without prescaler.
+#define TIMER_FREQ          ((uint32_t)32768UL)
+
+/* A compare value one tick or less ahead of the counter may not trigger
+** its event.
+*/
+#define TIMER_TICKS_MIN     2
+
+// The timeout uses the compare channel 0 of LUOS_TIMER.
+#define TIMER_CC            0
+
+/* Set when the deadline passed before its compare value was written: the
+** interrupt is then pended by software, without a compare event.
+*/
+static volatile bool s_timer_forced = false;
+
+#else
+
+#define TIMER_FREQ          (APP_TIMER_CLOCK_FREQ                       \
+                             / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))
+
+/* The timeout is a deadline kept in RAM: pushing it later only updates
+** it, and the timer, when it fires before the deadline, is started again
+** for the remaining time. The timer is only stopped and started again
+** when the deadline moves before its expiration.
+*/
+
+// Timeout deadline: start and length in RTC ticks.
+static bool     s_deadline_set      = false;
+static uint32_t s_deadline_start    = 0;
+static uint32_t s_deadline_ticks    = 0;
+
+// Underlying timer expiration: start and length in RTC ticks.
+static bool     s_timer_running     = false;
+static uint32_t s_timer_start       = 0;
+static uint32_t s_timer_ticks       = 0;
+
+#endif /* LUOS_TIMER_BACKEND */
+
+// Microseconds in a second.
+#define US_IN_SECOND        ((uint32_t)1000000UL)
+
+// Timer ticks per bit time, in 16.16 fixed point, see LuosHAL_TimeoutSetScale.
+static uint32_t s_bit_ticks_q16     = 0;
+
+// Shortest timeout, in timer ticks.
+static uint32_t s_ticks_min         = 0;
+
+#if (LUOS_TIMER_STATS != DISABLE)
+// Deadline of the pending timeout, in microseconds.
+static uint64_t         s_deadline_us   = 0;
+
+static timeout_stats_t  s_stats         = {.late_min = UINT32_MAX};
+#endif /* LUOS_TIMER_STATS */
+
+#if (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+/* Set when the timeout fires, cleared by the next reset: the Luos
+** reception runs from the main loop, and so does its timeout.
+*/
+static volatile bool    s_timeout_due   = false;
+#endif /* COM_RX_DEFERRED */
+
 /*      INITIALIZATIONS                                             */
 
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_APP_TIMER)
 // Timer instance.
 APP_TIMER_DEF(s_timer);
+#endif /* LUOS_TIMER_APP_TIMER */
 
 /*      STATIC FUNCTIONS                                            */
 
 static inline void LuosHAL_ComTimeout(void);
 
+// Converts a number of bit times to timer ticks, rounded up.
+static inline uint32_t timer_bits_to_ticks(uint16_t nbrbit);
+
+// Sets the timeout deadline the given amount of ticks from now.
+static void timer_start(uint32_t nb_ticks);
+
+// Records the deadline of a timeout starting now, for the statistics.
+static inline void timer_stats_arm(uint32_t ticks);
+
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_APP_TIMER)
+// Ticks left from now before the end of a span, 0 once it is over.
+static inline uint32_t timer_ticks_left(uint32_t now, uint32_t start,
+                                        uint32_t ticks);
+
+// Starts the underlying timer to expire in the given amount of ticks.
+static void timer_arm(uint32_t now, uint32_t ticks);
+
 /*      CALLBACKS                                                   */
 
 // Calls the Luos Timer interruption handler. Context is not used.
 static void LuosHAL_TimerEventHandler(void* context);
+#endif /* LUOS_TIMER_APP_TIMER */
+
+#if (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+// Hands an expired timeout to Luos from the main loop.
+static void timer_sched_handler(void* event_data, uint16_t event_size);
+#endif /* COM_RX_DEFERRED */
 
 
 /******************************************************************************
@@ -44,34 +156,115 @@ static void LuosHAL_TimerEventHandler(void* context);
  ******************************************************************************/
 void LuosHAL_TimeoutInit(void)
 {
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_RTC)
+    // Runs from the LFCLK, already started by the SoftDevice.
+    LUOS_TIMER_CLOCK_ENABLE();
+
+    nrf_rtc_task_trigger(LUOS_TIMER, NRF_RTC_TASK_STOP);
+    nrf_rtc_task_trigger(LUOS_TIMER, NRF_RTC_TASK_CLEAR);
+    nrf_rtc_prescaler_set(LUOS_TIMER, 0);
+    nrf_rtc_int_disable(LUOS_TIMER, NRF_RTC_INT_COMPARE0_MASK);
+    nrf_rtc_event_clear(LUOS_TIMER, NRF_RTC_EVENT_COMPARE_0);
+
+    ret_code_t err_code = sd_nvic_SetPriority(LUOS_TIMER_IRQ,
+                                              LUOS_TIMER_PRIO);
+    APP_ERROR_CHECK(err_code);
+    err_code = sd_nvic_ClearPendingIRQ(LUOS_TIMER_IRQ);
+    APP_ERROR_CHECK(err_code);
+    err_code = sd_nvic_EnableIRQ(LUOS_TIMER_IRQ);
+    APP_ERROR_CHECK(err_code);
+
+    nrf_rtc_task_trigger(LUOS_TIMER, NRF_RTC_TASK_START);
+#else
     ret_code_t err_code = app_timer_create(&s_timer,
                                            APP_TIMER_MODE_SINGLE_SHOT,
                                            LuosHAL_TimerEventHandler);
     APP_ERROR_CHECK(err_code);
+#endif /* LUOS_TIMER_BACKEND */
+}
+
+/******************************************************************************
+ * @brief Luos Timeout scale, on a baudrate change or a new BLE connection
+ * @param baudrate : Bits per second on the link, gives the bit time
+ * @param min_us : Shortest timeout in microseconds, whatever the bit count
+ * @return None
+ ******************************************************************************/
+void LuosHAL_TimeoutSetScale(uint32_t baudrate, uint32_t min_us)
+{
+    LuosHAL_SetIrqState(false);
+
+    s_bit_ticks_q16 = (baudrate != 0)
+                      ? (uint32_t)(((uint64_t)TIMER_FREQ << 16) / baudrate)
+                      : 0;
+    s_ticks_min     = (uint32_t)(((uint64_t)min_us * TIMER_FREQ
+                                  + US_IN_SECOND - 1) / US_IN_SECOND);
+
+    LuosHAL_SetIrqState(true);
 }
 
 /******************************************************************************
  * @brief Luos Timeout communication
- * @param None
+ * @param nbrbit : Timeout in bit times, 0 to cancel it
  * @return None
  ******************************************************************************/
 void LuosHAL_ResetTimeout(uint16_t nbrbit)
 {
-    ret_code_t err_code;
+    LuosHAL_SetIrqState(false);
 
-    err_code = app_timer_stop(s_timer);
-    APP_ERROR_CHECK(err_code);
+    #if (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+    // A timeout not yet handed to Luos is outdated by the new deadline.
+    s_timeout_due = false;
+    #endif /* COM_RX_DEFERRED */
+
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_RTC)
+    /* A compare event already raised is cleared, the interrupt handler
+    ** ignores a pending interrupt without it.
+    */
+    nrf_rtc_int_disable(LUOS_TIMER, NRF_RTC_INT_COMPARE0_MASK);
+    nrf_rtc_event_clear(LUOS_TIMER, NRF_RTC_EVENT_COMPARE_0);
+    s_timer_forced = false;
+#else
+    // A running timer finds no deadline when it fires.
+    s_deadline_set = false;
+#endif /* LUOS_TIMER_BACKEND */
 
     if (nbrbit != 0)
     {
-        const uint32_t nb_ticks = APP_TIMER_TICKS(nbrbit);
-        err_code = app_timer_start(s_timer, nb_ticks, NULL);
-        APP_ERROR_CHECK(err_code);
+        timer_start(timer_bits_to_ticks(nbrbit));
     }
+
+    LuosHAL_SetIrqState(true);
+}
+
+/******************************************************************************
+ * @brief Luos Timeout statistics, see LUOS_TIMER_STATS
+ * @param None
+ * @return Statistics since startup, NULL when disabled
+ ******************************************************************************/
+const timeout_stats_t* LuosHAL_GetTimeoutStats(void)
+{
+#if (LUOS_TIMER_STATS != DISABLE)
+    return &s_stats;
+#else
+    return NULL;
+#endif /* LUOS_TIMER_STATS */
 }
 
 void LUOS_TIMER_IRQHANDLER()
 {
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_RTC)
+    if (!nrf_rtc_event_pending(LUOS_TIMER, NRF_RTC_EVENT_COMPARE_0)
+        && !s_timer_forced)
+    {
+        return;
+    }
+
+    // Single shot.
+    nrf_rtc_int_disable(LUOS_TIMER, NRF_RTC_INT_COMPARE0_MASK);
+    nrf_rtc_event_clear(LUOS_TIMER, NRF_RTC_EVENT_COMPARE_0);
+    s_timer_forced = false;
+#endif /* LUOS_TIMER_RTC */
+
     LuosHAL_ComTimeout();
 }
 
@@ -82,20 +275,189 @@ void LUOS_TIMER_IRQHANDLER()
  ******************************************************************************/
 static inline void LuosHAL_ComTimeout(void)
 {
-    ret_code_t err_code = app_timer_stop(s_timer);
-    APP_ERROR_CHECK(err_code);
+    #if (LUOS_TIMER_STATS != DISABLE)
+    uint64_t now_us = LuosHAL_GetTimeUs();
+    uint32_t late   = (now_us > s_deadline_us)
+                      ? (uint32_t)(now_us - s_deadline_us) : 0;
+
+    s_stats.fired++;
+    s_stats.late_sum += late;
+    if (late < s_stats.late_min)
+    {
+        s_stats.late_min = late;
+    }
+    if (late > s_stats.late_max)
+    {
+        s_stats.late_max = late;
+    }
+    #endif /* LUOS_TIMER_STATS */
+
+    #if (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+    s_timeout_due = true;
 
+    ret_code_t err_code = app_sched_event_put(NULL, 0, timer_sched_handler);
+    if (err_code != NRF_SUCCESS)
+    {
+        // Scheduler queue full: fires again shortly.
+        LuosHAL_SetIrqState(false);
+        timer_start(1);
+        LuosHAL_SetIrqState(true);
+    }
+    #else
     if (ctx.tx.lock == true)
     {
         Recep_Timeout();
     }
+    #endif /* COM_RX_DEFERRED */
+}
+
+#if (COM_RX_DEFERRED == COM_RX_DEFER_SCHED)
+static void timer_sched_handler(void* event_data, uint16_t event_size)
+{
+    (void)event_data;
+    (void)event_size;
+
+    LuosHAL_SetIrqState(false);
+    bool due = s_timeout_due;
+    s_timeout_due = false;
+    LuosHAL_SetIrqState(true);
+
+    if (due && (ctx.tx.lock == true))
+    {
+        Recep_Timeout();
+    }
+}
+#endif /* COM_RX_DEFERRED */
+
+static inline uint32_t timer_bits_to_ticks(uint16_t nbrbit)
+{
+    uint32_t ticks = (uint32_t)(((uint64_t)nbrbit * s_bit_ticks_q16
+                                 + 0xFFFF) >> 16);
+    return (ticks > s_ticks_min) ? ticks : s_ticks_min;
+}
+
+static void timer_start(uint32_t nb_ticks)
+{
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_RTC)
+    if (nb_ticks < TIMER_TICKS_MIN)
+    {
+        nb_ticks = TIMER_TICKS_MIN;
+    }
+
+    // Only a register write, no need to defer it.
+    const uint32_t deadline = (nrf_rtc_counter_get(LUOS_TIMER) + nb_ticks)
+                              & RTC_COUNTER_COUNTER_Msk;
+    nrf_rtc_cc_set(LUOS_TIMER, TIMER_CC, deadline);
+    nrf_rtc_int_enable(LUOS_TIMER, NRF_RTC_INT_COMPARE0_MASK);
+
+    /* The SoftDevice may have run since the counter was read: a deadline
+    ** passed, or too close to raise its event, would only match once the
+    ** counter wraps, 512 s later.
+    */
+    const uint32_t left = (deadline - nrf_rtc_counter_get(LUOS_TIMER))
+                          & RTC_COUNTER_COUNTER_Msk;
+    if ((left < TIMER_TICKS_MIN) || (left > nb_ticks))
+    {
+        s_timer_forced = true;
+
+        ret_code_t err_code = sd_nvic_SetPendingIRQ(LUOS_TIMER_IRQ);
+        APP_ERROR_CHECK(err_code);
+    }
+#else
+    const uint32_t now = app_timer_cnt_get();
+
+    s_deadline_set      = true;
+    s_deadline_start    = now;
+    s_deadline_ticks    = nb_ticks;
+
+    // A later deadline is handled when the timer fires.
+    if (!s_timer_running
+        || (nb_ticks < timer_ticks_left(now, s_timer_start,
+                                        s_timer_ticks)))
+    {
+        timer_arm(now, nb_ticks);
+    }
+#endif /* LUOS_TIMER_BACKEND */
+
+    timer_stats_arm(nb_ticks);
+}
+
+static inline void timer_stats_arm(uint32_t ticks)
+{
+    #if (LUOS_TIMER_STATS != DISABLE)
+    s_deadline_us = LuosHAL_GetTimeUs()
+                    + ((uint64_t)ticks * US_IN_SECOND) / TIMER_FREQ;
+    #else
+    (void)ticks;
+    #endif /* LUOS_TIMER_STATS */
+}
+
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_APP_TIMER)
+static inline uint32_t timer_ticks_left(uint32_t now, uint32_t start,
+                                        uint32_t ticks)
+{
+    uint32_t elapsed = app_timer_cnt_diff_compute(now, start);
+    return (elapsed < ticks) ? (ticks - elapsed) : 0;
+}
+
+static void timer_arm(uint32_t now, uint32_t ticks)
+{
+    ret_code_t err_code;
+
+    if (s_timer_running)
+    {
+        err_code = app_timer_stop(s_timer);
+        APP_ERROR_CHECK(err_code);
+    }
+
+    if (ticks < APP_TIMER_MIN_TIMEOUT_TICKS)
+    {
+        ticks = APP_TIMER_MIN_TIMEOUT_TICKS;
+    }
+
+    err_code = app_timer_start(s_timer, ticks, NULL);
+    APP_ERROR_CHECK(err_code);
+
+    s_timer_running = true;
+    s_timer_start   = now;
+    s_timer_ticks   = ticks;
 }
 
 static void LuosHAL_TimerEventHandler(void* context)
 {
+    LuosHAL_SetIrqState(false);
+
+    s_timer_running = false;
+
+    bool expired = false;
+    if (s_deadline_set)
+    {
+        const uint32_t now  = app_timer_cnt_get();
+        const uint32_t left = timer_ticks_left(now, s_deadline_start,
+                                               s_deadline_ticks);
+        if (left == 0)
+        {
+            s_deadline_set  = false;
+            expired         = true;
+        }
+        else
+        {
+            // The deadline moved later since the timer was started.
+            timer_arm(now, left);
+        }
+    }
+
+    LuosHAL_SetIrqState(true);
+
+    if (!expired)
+    {
+        return;
+    }
+
     #ifdef DEBUG
     NRF_LOG_INFO("COM timeout!");
     #endif /* DEBUG */
 
     LUOS_TIMER_IRQHANDLER();
 }
+#endif /* LUOS_TIMER_APP_TIMER */
@@ -1,9 +1,26 @@
 #ifndef LUOS_HAL_TIMER_H
 #define LUOS_HAL_TIMER_H
 
-// Default timeout value in milliseconds.
-#define DEFAULT_TIMEOUT 100
+#include <stdint.h>     // uint32_t, uint64_t
+
+/* Default timeout value in bit times, see LuosHAL_TimeoutSetScale for
+** their length.
+*/
+#define DEFAULT_TIMEOUT 20
+
+// Delay between timeout deadlines and Luos being called, in microseconds.
+typedef struct
+{
+    uint32_t fired;     // Timeouts expired
+    uint32_t late_min;  // Shortest delay
+    uint32_t late_max;  // Longest delay
+    uint64_t late_sum;  // All of them
+} timeout_stats_t;
 
 void LuosHAL_TimeoutInit(void);
 
+void LuosHAL_TimeoutSetScale(uint32_t baudrate, uint32_t min_us);
+
+const timeout_stats_t* LuosHAL_GetTimeoutStats(void);
+
 #endif /* ! LUOS_HAL_TIMER_H */
@@ -14,6 +14,40 @@ void timer_irq_handler(void);
                                     \
                                       } while(0U)
 #endif
+/* Backend of the COM timeout:
+**  - LUOS_TIMER_APP_TIMER: a single shot app_timer, shared with the
+**    application timers and called from the app_timer interrupt, whose
+**    priority (APP_TIMER_CONFIG_IRQ_PRIORITY) must then be the one of
+**    the Luos reception, see LUOS_TIMER_PRIO,
+**  - LUOS_TIMER_RTC: the compare channel 0 of a dedicated RTC instance,
+**    LUOS_TIMER, handled directly in its interrupt. It must not be used
+**    by the SoftDevice (RTC0) nor by the app_timer (RTC1).
+*/
+#define LUOS_TIMER_APP_TIMER    0x01
+#define LUOS_TIMER_RTC          0x02
+
+#ifndef LUOS_TIMER_BACKEND
+#define LUOS_TIMER_BACKEND      LUOS_TIMER_APP_TIMER
+#endif
+
+#if (LUOS_TIMER_BACKEND == LUOS_TIMER_RTC)
+#ifndef LUOS_TIMER
+#define LUOS_TIMER              NRF_RTC2
+#endif
+#ifndef LUOS_TIMER_IRQ
+#define LUOS_TIMER_IRQ          RTC2_IRQn
+#endif
+#ifndef LUOS_TIMER_IRQHANDLER
+#define LUOS_TIMER_IRQHANDLER() RTC2_IRQHandler()
+#endif
+/* The timeout resets the Luos reception: it must not preempt it, hence
+** the priority of the SoftDevice events and of COM_RX_SWI_PRIO. With
+** COM_RX_DEFER_SCHED, the timeout is handed to Luos from the main loop.
+*/
+#ifndef LUOS_TIMER_PRIO
+#define LUOS_TIMER_PRIO         APP_IRQ_PRIORITY_LOWEST
+#endif
+#else
 #ifndef LUOS_TIMER
 #define LUOS_TIMER              DISABLE
 #endif
@@ -23,5 +57,14 @@ void timer_irq_handler(void);
 #ifndef LUOS_TIMER_IRQHANDLER
 #define LUOS_TIMER_IRQHANDLER() timer_irq_handler()
 #endif
+#endif /* LUOS_TIMER_BACKEND */
+
+/* Measure the delay between the timeout deadlines and their handling, see
+** LuosHAL_GetTimeoutStats: running the same load with each backend on
+** the target compares their jitter.
+*/
+#ifndef LUOS_TIMER_STATS
+#define LUOS_TIMER_STATS        DISABLE
+#endif
 
 #endif /* ! LUOS_HAL_TIMER_CONFIG_H */
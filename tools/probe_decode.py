@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Decodes the probe dump of LuosHAL_ProbeDump.
+
+Reads a log (RTT or UART output of a DEBUG build) and keeps its lines
+        PROBE <name> <count> <min> <max> <mean>
+with cycles at SystemCoreClock, whatever the log prefix before them. When
+the dump appears several times, the last one of each probe is kept.
+
+Usage:
+    tools/probe_decode.py [--clock HZ] [LOG]
+LOG defaults to the standard input, HZ to 64000000 (nRF52832).
+"""
+
+import argparse
+import re
+import sys
+
+PROBE_LINE = re.compile(
+    r"PROBE\s+(?P<name>\S+)\s+(?P<count>\d+)\s+(?P<min>\d+)"
+    r"\s+(?P<max>\d+)\s+(?P<mean>\d+)"
+)
+
+
+def parse(lines):
+    """Returns {name: (count, min, max, mean)} in cycles, last dump wins."""
+    probes = {}
+    for line in lines:
+        match = PROBE_LINE.search(line)
+        if match is None:
+            continue
+        probes[match.group("name")] = tuple(
+            int(match.group(field)) for field in ("count", "min", "max", "mean")
+        )
+    return probes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", nargs="?", type=argparse.FileType("r"),
+                        default=sys.stdin, help="log to decode")
+    parser.add_argument("--clock", type=float, default=64e6,
+                        help="CPU clock in Hz (default: %(default).0f)")
+    args = parser.parse_args()
+
+    probes = parse(args.log)
+    if not probes:
+        sys.exit("No PROBE line found.")
+
+    us_per_cycle = 1e6 / args.clock
+    print(f"{'probe':<16} {'count':>10} {'min us':>10} {'max us':>10}"
+          f" {'mean us':>10} {'total ms':>10}")
+    for name, (count, cycles_min, cycles_max, mean) in probes.items():
+        if count == 0:
+            print(f"{name:<16} {count:>10} {'-':>10} {'-':>10} {'-':>10}"
+                  f" {'-':>10}")
+            continue
+        print(f"{name:<16} {count:>10}"
+              f" {cycles_min * us_per_cycle:>10.2f}"
+              f" {cycles_max * us_per_cycle:>10.2f}"
+              f" {mean * us_per_cycle:>10.2f}"
+              f" {count * mean * us_per_cycle / 1000:>10.2f}")
+
+
+if __name__ == "__main__":
+    main()